@@ -1,17 +1,27 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include "parser_common.h"
 #include "keys_def.h"
 
+/* Scalar decoded and checked by rslib. Opaque: it must only be written by rslib */
+typedef struct {
+    uint64_t opaque[4];
+} rs_scalar_t;
+
 /* Interface functions with jubjub crate */
 parser_error_t from_bytes_wide(const uint8_t input[64], uint8_t output[32]);
 parser_error_t scalar_multiplication(const uint8_t input[32], constant_key_t key, uint8_t output[32]);
+parser_error_t compute_ak_nk(const uint8_t ask[32], const uint8_t nsk[32], uint8_t ak[32], uint8_t nk[32]);
 parser_error_t get_default_diversifier_list(const uint8_t dk[32], uint8_t start_index[11], uint8_t d_l[44]);
-parser_error_t get_default_diversifier(const uint8_t dk[32], uint8_t start_index[11], uint8_t d[11]);
-parser_error_t get_pkd(const uint8_t ivk_ptr[32], const uint8_t hash[32], uint8_t pk_d[32]);
+parser_error_t get_diversifier_list(const uint8_t dk[32], uint8_t start_index[11], uint8_t *d_l, size_t d_l_len);
+void clear_diversifier_generator();
 parser_error_t get_pkd(const uint8_t ivk_ptr[32], const uint8_t hash[32], uint8_t pk_d[32]);
 bool is_valid_diversifier(const uint8_t hash[32]);
-parser_error_t randomized_secret_from_seed(const uint8_t ask[32], const uint8_t alpha[32], uint8_t output[32]);
-parser_error_t compute_sbar(const uint8_t s[32], uint8_t r[32], uint8_t rsk[32], uint8_t sbar[32]);
-parser_error_t add_points(const uint8_t hash[32], const uint8_t value[32], const uint8_t scalar[32], uint8_t cv[32]);
+bool prepare_diversifier(const uint8_t hash[32], uint8_t g_d[64]);
+parser_error_t get_pkd_list(const uint8_t ivk_ptr[32], const uint8_t *g_d_list, size_t count, uint8_t *pk_d_list);
+parser_error_t scalar_from_bytes(const uint8_t input[32], rs_scalar_t *output);
+parser_error_t randomized_secret(const rs_scalar_t *ask, const uint8_t alpha[32], rs_scalar_t *rsk, uint8_t rsk_bytes[32]);
+parser_error_t compute_sbar(const uint8_t s[32], const uint8_t r[32], const rs_scalar_t *rsk, uint8_t sbar[32]);
+parser_error_t compute_value_commitment(const uint8_t hash[32], uint64_t value, const uint8_t rcv[32], uint8_t cv[32]);
@@ -0,0 +1,292 @@
+/*******************************************************************************
+*   (c) 2018 - 2024 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+// Signed window tables [-8G, .., -G, identity, G, .., 8G] for the fixed generators,
+// used by window::mul_fixed. They live in flash, so fixed-base multiplications need
+// no table on the stack. Entries are affine (u, v) as canonical Fq limbs.
+
+use crate::window::TABLE_SIZE;
+use jubjub::{AffineNielsPoint, AffinePoint, Fq};
+
+macro_rules! niels {
+    ($u:expr, $v:expr) => {
+        AffinePoint::from_raw_unchecked(Fq::from_raw($u), Fq::from_raw($v)).to_niels()
+    };
+}
+
+pub static SPENDING_KEY_GENERATOR_TABLE: [AffineNielsPoint; TABLE_SIZE] = [
+    // -8
+    niels!(
+        [0x7624_f3ed_cecb_bb44, 0x27b2_c89c_e234_1df7, 0x64a1_8c1e_8b4e_48f6, 0x6535_fa2c_b5b7_f5e8],
+        [0xa964_25b3_e0e6_c4ef, 0xc431_7a42_b8c2_c783, 0xab46_2ca4_6298_2cad, 0x247c_80d9_78f4_f46e]
+    ),
+    // -7
+    niels!(
+        [0x99b2_e485_6e8e_ea84, 0x5248_5bc8_9e4b_bf07, 0x09b9_2d77_ff51_9e23, 0x3d90_5ab4_b8a9_baf4],
+        [0xe382_7426_48f8_53f9, 0x35eb_616e_bab7_92a9, 0xd949_bdd5_e414_7276, 0x2e68_c379_acd2_f556]
+    ),
+    // -6
+    niels!(
+        [0xe114_08fa_c875_77e8, 0xa0a9_9464_35d5_49e1, 0xd2be_1cb1_2ce6_c499, 0x655b_dc04_51de_b807],
+        [0x1680_def2_956b_1750, 0x61ee_a850_2d0a_0607, 0x716f_97a4_4b26_c953, 0x0a7c_294a_9407_9ece]
+    ),
+    // -5
+    niels!(
+        [0xe2bf_ac39_fd1f_b4f2, 0xedd1_9f23_0c0c_f27f, 0xaf64_5005_3c89_fda1, 0x3e7f_c273_e834_27e7],
+        [0x0c71_fa97_d861_3a2f, 0x10d0_8607_3863_f708, 0xc8ce_1c4e_78a4_620e, 0x05e4_1bd9_9ef7_e33f]
+    ),
+    // -4
+    niels!(
+        [0x36e2_3e54_18c7_062e, 0xcaf4_a863_955b_24ec, 0xa2a7_5429_245a_3852, 0x347e_e59a_727e_199b],
+        [0x155f_9e79_54c6_650c, 0x0d7e_3c6a_dc3a_6c9c, 0x8722_c71f_635f_fdbc, 0x609a_ba51_d8cd_09e0]
+    ),
+    // -3
+    niels!(
+        [0xe06b_f2ee_a769_1a6d, 0xdc86_ca02_8105_fc4c, 0x72d1_4dc6_8e88_4df1, 0x4ce2_6bc9_f9e9_ddd4],
+        [0xf03d_6317_f98b_7608, 0x0c3e_baa9_0af8_935b, 0xe4c2_04c4_5b94_e529, 0x5433_6029_04b6_3a81]
+    ),
+    // -2
+    niels!(
+        [0x119e_5bc7_7315_ddf3, 0x624f_e565_085c_a8b7, 0xd43e_ebd1_6fa4_b19a, 0x4db3_25f2_2d67_8a9f],
+        [0x21d7_2015_ac27_06b2, 0x4e2b_4d73_7215_6676, 0xecbc_1971_61a2_c618, 0x1b6d_ccc0_6df5_65cb]
+    ),
+    // -1
+    niels!(
+        [0x138a_d6c1_7edb_7baf, 0x19c7_f3cf_7f4e_fbde, 0x3b08_1556_69b5_77df, 0x18b5_1230_7fb5_6815],
+        [0x14b6_2623_a186_b4b1, 0x2012_d031_f624_fd52, 0x75de_fecf_f1f4_9ef2, 0x0cbc_5f9f_1e52_e0ab]
+    ),
+    // 0
+    niels!(
+        [0x0000_0000_0000_0000, 0x0000_0000_0000_0000, 0x0000_0000_0000_0000, 0x0000_0000_0000_0000],
+        [0x0000_0000_0000_0001, 0x0000_0000_0000_0000, 0x0000_0000_0000_0000, 0x0000_0000_0000_0000]
+    ),
+    // 1
+    niels!(
+        [0xec75_293d_8124_8452, 0x39f5_b033_80af_6020, 0xf831_c2b1_9fec_6026, 0x5b38_9522_a9e8_1532],
+        [0x14b6_2623_a186_b4b1, 0x2012_d031_f624_fd52, 0x75de_fecf_f1f4_9ef2, 0x0cbc_5f9f_1e52_e0ab]
+    ),
+    // 2
+    niels!(
+        [0xee61_a437_8cea_220e, 0xf16d_be9d_f7a1_b347, 0x5efa_ec36_99fd_266a, 0x263a_8160_fc35_f2a8],
+        [0x21d7_2015_ac27_06b2, 0x4e2b_4d73_7215_6676, 0xecbc_1971_61a2_c618, 0x1b6d_ccc0_6df5_65cb]
+    ),
+    // 3
+    niels!(
+        [0x1f94_0d10_5896_e594, 0x7736_da00_7ef8_5fb2, 0xc068_8a41_7b19_8a13, 0x270b_3b89_2fb3_9f73],
+        [0xf03d_6317_f98b_7608, 0x0c3e_baa9_0af8_935b, 0xe4c2_04c4_5b94_e529, 0x5433_6029_04b6_3a81]
+    ),
+    // 4
+    niels!(
+        [0xc91d_c1aa_e738_f9d3, 0x88c8_fb9f_6aa3_3712, 0x9092_83de_e547_9fb2, 0x3f6e_c1b8_b71f_63ac],
+        [0x155f_9e79_54c6_650c, 0x0d7e_3c6a_dc3a_6c9c, 0x8722_c71f_635f_fdbc, 0x609a_ba51_d8cd_09e0]
+    ),
+    // 5
+    niels!(
+        [0x1d40_53c5_02e0_4b0f, 0x65ec_04df_f3f1_697f, 0x83d5_8802_cd17_da63, 0x356d_e4df_4169_5560],
+        [0x0c71_fa97_d861_3a2f, 0x10d0_8607_3863_f708, 0xc8ce_1c4e_78a4_620e, 0x05e4_1bd9_9ef7_e33f]
+    ),
+    // 6
+    niels!(
+        [0x1eeb_f704_378a_8819, 0xb314_0f9e_ca29_121d, 0x607b_bb56_dcbb_136b, 0x0e91_cb4e_d7be_c540],
+        [0x1680_def2_956b_1750, 0x61ee_a850_2d0a_0607, 0x716f_97a4_4b26_c953, 0x0a7c_294a_9407_9ece]
+    ),
+    // 7
+    niels!(
+        [0x664d_1b79_9171_157d, 0x0175_483a_61b2_9cf7, 0x2980_aa90_0a50_39e2, 0x365d_4c9e_70f3_c254],
+        [0xe382_7426_48f8_53f9, 0x35eb_616e_bab7_92a9, 0xd949_bdd5_e414_7276, 0x2e68_c379_acd2_f556]
+    ),
+    // 8
+    niels!(
+        [0x89db_0c11_3134_44bd, 0x2c0a_db66_1dca_3e07, 0xce98_4be9_7e53_8f0f, 0x0eb7_ad26_73e5_875f],
+        [0xa964_25b3_e0e6_c4ef, 0xc431_7a42_b8c2_c783, 0xab46_2ca4_6298_2cad, 0x247c_80d9_78f4_f46e]
+    ),
+];
+
+pub static PROOF_GENERATION_KEY_GENERATOR_TABLE: [AffineNielsPoint; TABLE_SIZE] = [
+    // -8
+    niels!(
+        [0x9ed5_63ce_f604_7444, 0x2c96_0718_91b5_7d39, 0x3b41_7344_b3d4_6b07, 0x4a86_eb4f_2453_c623],
+        [0x585c_c0c2_9e02_65fd, 0x64be_5d1d_c894_2080, 0x55e2_b90d_ee34_09b8, 0x1fd2_725d_c160_5c29]
+    ),
+    // -7
+    niels!(
+        [0x2943_f084_9125_35fc, 0x053b_c828_6e02_0408, 0xb7c8_46cc_d942_99bd, 0x2891_19c1_1695_b1f3],
+        [0xd690_c550_9d73_e208, 0xb39e_69b1_76c8_0ca5, 0x3323_85a0_29bd_83ae, 0x463e_bd37_7821_2efd]
+    ),
+    // -6
+    niels!(
+        [0xda7d_b0ee_1d35_9b0c, 0xe5f8_70fc_a5a0_c4a9, 0x47fb_684f_21dc_6a3c, 0x5bf3_797a_69ce_6d82],
+        [0x3d4e_a9e3_59ae_0b02, 0xfa7e_2057_f138_f34b, 0xae65_c412_f7d0_4cc9, 0x35aa_91be_55b1_cb6d]
+    ),
+    // -5
+    niels!(
+        [0xb991_f7a6_9513_e081, 0x7103_71ed_4623_b3f0, 0x523e_26e7_d98f_e33f, 0x0d78_06ca_a758_f514],
+        [0x87f0_192e_f8fa_e8ab, 0x53ff_c33e_a800_561a, 0x26f5_065d_96d8_6679, 0x4e89_a303_473e_98bb]
+    ),
+    // -4
+    niels!(
+        [0x0741_076b_4ede_38c4, 0xd166_f691_a3d7_4bc6, 0x35e2_a5bd_858f_27d2, 0x0d0f_2ec8_c464_094f],
+        [0x0c70_e974_f811_869d, 0x49ab_282e_b875_f5bc, 0x9f1e_e98e_8479_8ab2, 0x23ee_426a_ccec_c17c]
+    ),
+    // -3
+    niels!(
+        [0x1f26_acd7_97dd_344f, 0xf7da_6d76_b007_8e05, 0x973e_f045_f8ab_13a7, 0x1753_55fc_a9b1_54c6],
+        [0x6226_6036_719a_5f63, 0xf50e_60e6_e2ff_10f8, 0xcf27_9bd8_784b_3834, 0x3153_267a_0d27_0153]
+    ),
+    // -2
+    niels!(
+        [0x1f2c_3add_8743_880e, 0x49c3_3ac7_8de9_585f, 0x1436_b696_65c8_2cf3, 0x19ff_c6b8_fe9b_d019],
+        [0xfb62_3151_daa2_bfba, 0x5462_e211_b99b_87b2, 0x42d1_1047_7045_4331, 0x162f_0cb2_bc60_f25a]
+    ),
+    // -1
+    niels!(
+        [0xa0c3_8dc4_5dac_e49b, 0x3598_abd0_980d_0141, 0xe797_e7a2_2287_db02, 0x2742_bc88_7a74_8ffc],
+        [0xfe6f_96be_c575_bff8, 0x36b4_9c71_a2af_0708, 0xc654_dfdd_3600_4de9, 0x0093_0d67_d690_6365]
+    ),
+    // 0
+    niels!(
+        [0x0000_0000_0000_0000, 0x0000_0000_0000_0000, 0x0000_0000_0000_0000, 0x0000_0000_0000_0000],
+        [0x0000_0000_0000_0001, 0x0000_0000_0000_0000, 0x0000_0000_0000_0000, 0x0000_0000_0000_0000]
+    ),
+    // 1
+    niels!(
+        [0x5f3c_723a_a253_1b66, 0x1e24_f832_67f1_5abd, 0x4ba1_f065_e719_fd03, 0x4caa_eaca_af28_ed4b],
+        [0xfe6f_96be_c575_bff8, 0x36b4_9c71_a2af_0708, 0xc654_dfdd_3600_4de9, 0x0093_0d67_d690_6365]
+    ),
+    // 2
+    niels!(
+        [0xe0d3_c521_78bc_77f3, 0x09fa_693b_7215_039f, 0x1f03_2171_a3d9_ab12, 0x59ed_e09a_2b01_ad2f],
+        [0xfb62_3151_daa2_bfba, 0x5462_e211_b99b_87b2, 0x42d1_1047_7045_4331, 0x162f_0cb2_bc60_f25a]
+    ),
+    // 3
+    niels!(
+        [0xe0d9_5327_6822_cbb2, 0x5be3_368c_4ff6_cdf9, 0x9bfa_e7c2_10f6_c45d, 0x5c9a_5156_7fec_2881],
+        [0x6226_6036_719a_5f63, 0xf50e_60e6_e2ff_10f8, 0xcf27_9bd8_784b_3834, 0x3153_267a_0d27_0153]
+    ),
+    // 4
+    niels!(
+        [0xf8be_f893_b121_c73d, 0x8256_ad71_5c27_1038, 0xfd57_324a_8412_b032, 0x66de_788a_6539_73f8],
+        [0x0c70_e974_f811_869d, 0x49ab_282e_b875_f5bc, 0x9f1e_e98e_8479_8ab2, 0x23ee_426a_ccec_c17c]
+    ),
+    // 5
+    niels!(
+        [0x466e_0858_6aec_1f80, 0xe2ba_3215_b9da_a80e, 0xe0fb_b120_3011_f4c5, 0x6675_a088_8244_8833],
+        [0x87f0_192e_f8fa_e8ab, 0x53ff_c33e_a800_561a, 0x26f5_065d_96d8_6679, 0x4e89_a303_473e_98bb]
+    ),
+    // 6
+    niels!(
+        [0x2582_4f10_e2ca_64f5, 0x6dc5_3306_5a5d_9755, 0xeb3e_6fb8_e7c5_6dc8, 0x17fa_2dd8_bfcf_0fc5],
+        [0x3d4e_a9e3_59ae_0b02, 0xfa7e_2057_f138_f34b, 0xae65_c412_f7d0_4cc9, 0x35aa_91be_55b1_cb6d]
+    ),
+    // 7
+    niels!(
+        [0xd6bc_0f7a_6eda_ca05, 0x4e81_dbda_91fc_57f6, 0x7b71_913b_305f_3e48, 0x4b5c_8d92_1307_cb54],
+        [0xd690_c550_9d73_e208, 0xb39e_69b1_76c8_0ca5, 0x3323_85a0_29bd_83ae, 0x463e_bd37_7821_2efd]
+    ),
+    // 8
+    niels!(
+        [0x612a_9c30_09fb_8bbd, 0x2727_9cea_6e48_dec5, 0xf7f8_64c3_55cd_6cfe, 0x2966_bc04_0549_b724],
+        [0x585c_c0c2_9e02_65fd, 0x64be_5d1d_c894_2080, 0x55e2_b90d_ee34_09b8, 0x1fd2_725d_c160_5c29]
+    ),
+];
+
+pub static VALUE_COMMITMENT_RANDOMNESS_GENERATOR_TABLE: [AffineNielsPoint; TABLE_SIZE] = [
+    // -8
+    niels!(
+        [0x4eee_5b32_4c41_6eab, 0xb5cc_e616_ce7a_2b90, 0xeef3_c214_b3b7_001d, 0x6d9e_c0f7_8a27_ca53],
+        [0x9394_2f14_f0ee_220e, 0x19a5_bf78_57e4_ba98, 0x9dce_8374_6235_fd9d, 0x64e3_bac6_37af_f6ee]
+    ),
+    // -7
+    niels!(
+        [0x542d_203f_d669_cc36, 0xf559_d909_8ab3_8479, 0xf4a8_563d_8b73_95d0, 0x0741_87e5_6057_ef62],
+        [0x6ddb_e2c1_7847_cf65, 0x371d_3e55_fc47_3314, 0xb881_38fd_859b_a587, 0x64aa_b588_0566_c220]
+    ),
+    // -6
+    niels!(
+        [0xbe89_49b7_2158_269c, 0xbf94_e7a3_efdb_65c7, 0xddd4_e0be_d132_14b4, 0x0077_8f93_8935_73ee],
+        [0x7646_4c42_3a02_b72f, 0x7943_96cd_ef1d_b5f2, 0x6e4d_403e_434c_1cb2, 0x02e3_8593_9d80_27bb]
+    ),
+    // -5
+    niels!(
+        [0xcf89_5d02_bd55_d947, 0x6a1a_7ef3_61d4_926b, 0x2a88_1171_4ca3_7185, 0x4b58_b627_33af_a32d],
+        [0x507d_c456_c129_0fe0, 0x1596_52b7_40af_026a, 0x47ba_1660_66ad_1997, 0x36f4_b36d_8fa3_08e6]
+    ),
+    // -4
+    niels!(
+        [0xf3f0_51e9_db54_8c2a, 0xed96_c76c_b9f0_50da, 0x3812_3fb0_e408_c128, 0x6dd5_d84a_4c6b_d1f0],
+        [0x579d_60fd_e228_37e2, 0xea65_8257_7d34_6af8, 0x9a39_f23b_9054_6a91, 0x0fda_8a0e_3212_5e37]
+    ),
+    // -3
+    niels!(
+        [0xe189_7599_a8cd_c999, 0x8114_7916_e296_8fcc, 0x66cf_3313_03cc_874e, 0x4552_90f0_0179_1e06],
+        [0x737f_e4a9_b175_1b8a, 0x53a3_4607_ab5e_18ca, 0xfd70_6744_742e_656a, 0x02b4_bf18_526b_202b]
+    ),
+    // -2
+    niels!(
+        [0x57d3_71e8_bb0c_43c3, 0xc239_d692_8a97_f41f, 0x5356_19cc_3b36_727f, 0x1581_95ee_f6a4_4cf9],
+        [0x2efc_72d8_3ea3_d571, 0xac48_6a28_5532_7dde, 0xf715_4ac7_ce95_5231, 0x648e_3c36_2fa7_4a8b]
+    ),
+    // -1
+    niels!(
+        [0x226c_2c9a_3473_1383, 0xc1f1_65ca_ca97_07ae, 0x6391_77e1_50c8_3c1b, 0x5780_0684_8f3f_1d6c],
+        [0x28e5_fce9_9ce6_92d0, 0xf94c_2daa_3603_02fe, 0xbc90_0cd4_b8ae_1150, 0x555f_11f9_b720_d50b]
+    ),
+    // 0
+    niels!(
+        [0x0000_0000_0000_0000, 0x0000_0000_0000_0000, 0x0000_0000_0000_0000, 0x0000_0000_0000_0000],
+        [0x0000_0000_0000_0001, 0x0000_0000_0000_0000, 0x0000_0000_0000_0000, 0x0000_0000_0000_0000]
+    ),
+    // 1
+    niels!(
+        [0xdd93_d364_cb8c_ec7e, 0x91cc_3e38_3567_5450, 0xcfa8_6026_b8d9_9be9, 0x1c6d_a0ce_9a5e_5fdb],
+        [0x28e5_fce9_9ce6_92d0, 0xf94c_2daa_3603_02fe, 0xbc90_0cd4_b8ae_1150, 0x555f_11f9_b720_d50b]
+    ),
+    // 2
+    niels!(
+        [0xa82c_8e16_44f3_bc3e, 0x9183_cd70_7566_67df, 0xdfe3_be3b_ce6b_6585, 0x5e6c_1164_32f9_304e],
+        [0x2efc_72d8_3ea3_d571, 0xac48_6a28_5532_7dde, 0xf715_4ac7_ce95_5231, 0x648e_3c36_2fa7_4a8b]
+    ),
+    // 3
+    niels!(
+        [0x1e76_8a65_5732_3668, 0xd2a9_2aec_1d67_cc32, 0xcc6a_a4f5_05d5_50b6, 0x2e9b_1663_2824_5f41],
+        [0x737f_e4a9_b175_1b8a, 0x53a3_4607_ab5e_18ca, 0xfd70_6744_742e_656a, 0x02b4_bf18_526b_202b]
+    ),
+    // 4
+    niels!(
+        [0x0c0f_ae15_24ab_73d7, 0x6626_dc96_460e_0b24, 0xfb27_9857_2599_16dc, 0x0617_cf08_dd31_ab57],
+        [0x579d_60fd_e228_37e2, 0xea65_8257_7d34_6af8, 0x9a39_f23b_9054_6a91, 0x0fda_8a0e_3212_5e37]
+    ),
+    // 5
+    niels!(
+        [0x3076_a2fc_42aa_26ba, 0xe9a3_250f_9e29_c993, 0x08b1_c696_bcfe_667f, 0x2894_f12b_f5ed_da1b],
+        [0x507d_c456_c129_0fe0, 0x1596_52b7_40af_026a, 0x47ba_1660_66ad_1997, 0x36f4_b36d_8fa3_08e6]
+    ),
+    // 6
+    niels!(
+        [0x4176_b647_dea7_d965, 0x9428_bc5f_1022_f637, 0x5564_f749_386f_c350, 0x7376_17bf_a068_0959],
+        [0x7646_4c42_3a02_b72f, 0x7943_96cd_ef1d_b5f2, 0x6e4d_403e_434c_1cb2, 0x02e3_8593_9d80_27bb]
+    ),
+    // 7
+    niels!(
+        [0xabd2_dfbf_2996_33cb, 0x5e63_caf9_754a_d785, 0x3e91_81ca_7e2e_4234, 0x6cac_1f6d_c945_8de5],
+        [0x6ddb_e2c1_7847_cf65, 0x371d_3e55_fc47_3314, 0xb881_38fd_859b_a587, 0x64aa_b588_0566_c220]
+    ),
+    // 8
+    niels!(
+        [0xb111_a4cc_b3be_9156, 0x9df0_bdec_3184_306e, 0x4446_15f3_55ea_d7e7, 0x064e_e65b_9f75_b2f4],
+        [0x9394_2f14_f0ee_220e, 0x19a5_bf78_57e4_ba98, 0x9dce_8374_6235_fd9d, 0x64e3_bac6_37af_f6ee]
+    ),
+];
@@ -0,0 +1,111 @@
+/*******************************************************************************
+*   (c) 2018 - 2024 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+// Scalar multiplication for PUBLIC scalars only (e.g. note values).
+// Branches and table indices depend on the scalar, so never use it with
+// secret data: secret scalars go through multiply_bits.
+
+use jubjub::{ExtendedNielsPoint, ExtendedPoint};
+
+const WINDOW: u32 = 4;
+// Odd multiples P, 3P, 5P, 7P
+const TABLE_SIZE: usize = 1 << (WINDOW - 2);
+// A u64 has at most 65 NAF digits
+const MAX_DIGITS: usize = 65;
+
+fn wnaf_digits(value: u64, digits: &mut [i8; MAX_DIGITS]) -> usize {
+    let mut k = value as u128;
+    let mut len = 0;
+
+    while k != 0 {
+        let mut digit = 0i8;
+        if k & 1 == 1 {
+            digit = (k & ((1 << WINDOW) - 1)) as i8;
+            if digit >= 1 << (WINDOW - 1) {
+                digit -= 1 << WINDOW;
+            }
+            if digit < 0 {
+                k += (-digit) as u128;
+            } else {
+                k -= digit as u128;
+            }
+        }
+        digits[len] = digit;
+        k >>= 1;
+        len += 1;
+    }
+    len
+}
+
+/// [value] * base for a public 64-bit value, in variable time
+pub fn mul_public_u64(base: &ExtendedPoint, value: u64) -> ExtendedPoint {
+    let mut digits = [0i8; MAX_DIGITS];
+    let len = wnaf_digits(value, &mut digits);
+
+    let double = base.double().to_niels();
+    let mut table = [base.to_niels(); TABLE_SIZE];
+    let mut multiple = *base;
+    for entry in table.iter_mut().skip(1) {
+        multiple = multiple + double;
+        *entry = multiple.to_niels();
+    }
+
+    let mut acc = ExtendedPoint::identity();
+    for &digit in digits[..len].iter().rev() {
+        acc = acc.double();
+        if digit > 0 {
+            acc = acc + table[(digit as usize - 1) / 2];
+        } else if digit < 0 {
+            acc = acc - table[((-digit) as usize - 1) / 2];
+        }
+    }
+    acc
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use jubjub::Fr;
+
+    // xorshift64*, enough to spread test values over the whole u64 range
+    fn next(state: &mut u64) -> u64 {
+        *state ^= *state >> 12;
+        *state ^= *state << 25;
+        *state ^= *state >> 27;
+        state.wrapping_mul(0x2545_f491_4f6c_dd1d)
+    }
+
+    fn generic(base: &ExtendedPoint, value: u64) -> ExtendedPoint {
+        base * Fr::from(value)
+    }
+
+    #[test]
+    fn matches_generic_multiplication() {
+        let base = crate::constants::SPENDING_KEY_GENERATOR.multiply_bits(&[7u8; 32]);
+        let mut state = 0x9e37_79b9_7f4a_7c15u64;
+
+        for value in [0u64, 1, 2, 7, 8, 15, 16, 0x7fff_ffff_ffff_ffff, u64::MAX] {
+            assert_eq!(mul_public_u64(&base, value), generic(&base, value));
+        }
+
+        for _ in 0..256 {
+            let value = next(&mut state);
+            assert_eq!(mul_public_u64(&base, value), generic(&base, value));
+            let small = value >> (value & 63);
+            assert_eq!(mul_public_u64(&base, small), generic(&base, small));
+        }
+    }
+}
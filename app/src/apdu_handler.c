@@ -26,14 +26,29 @@
 #include "view_internal.h"
 #include "actions.h"
 #include "tx.h"
+#include "tx_stream.h"
 #include "addr.h"
 #include "crypto.h"
+#include "crypto_helper.h"
 #include "coin.h"
 #include "zxmacros.h"
 #include "view_internal.h"
 #include "review_keys.h"
+#include "nvdata.h"
 
 static bool tx_initialized = false;
+static bool upload_streamed = false;
+static uint8_t upload_ins = 0;
+
+// Short APDUs carry up to 255 bytes. Extended APDUs (Lc = 0x00 followed by a 16-bit length)
+// are accepted for chunks on targets whose IO buffer can hold a larger payload.
+#define APDU_OFFSET_LC          (OFFSET_DATA - 1)
+#define APDU_EXT_LEN_SIZE       2u
+#define OFFSET_EXT_DATA         (OFFSET_DATA + APDU_EXT_LEN_SIZE)
+#define MAX_SHORT_APDU_PAYLOAD  (IO_APDU_BUFFER_SIZE - OFFSET_DATA < 255u ? IO_APDU_BUFFER_SIZE - OFFSET_DATA : 255u)
+#define MAX_EXT_APDU_PAYLOAD    (IO_APDU_BUFFER_SIZE - OFFSET_EXT_DATA)
+#define EXT_APDU_SUPPORTED      (MAX_EXT_APDU_PAYLOAD > MAX_SHORT_APDU_PAYLOAD)
+#define MAX_CHUNK_PAYLOAD       (EXT_APDU_SUPPORTED ? MAX_EXT_APDU_PAYLOAD : MAX_SHORT_APDU_PAYLOAD)
 
 __Z_INLINE void extractHDPath(uint32_t rx, uint32_t offset) {
     ZEMU_LOGF(50, "Extract HDPath\n")
@@ -57,56 +72,110 @@ __Z_INLINE void extractHDPath(uint32_t rx, uint32_t offset) {
     if (!mainnet && !testnet) {
         THROW(APDU_CODE_DATA_INVALID);
     }
+
+    if (crypto_setNetwork(hdPath[1]) != zxerr_ok) {
+        THROW(APDU_CODE_EXECUTION_ERROR);
+    }
+}
+
+// Returns the offset of the chunk payload, handling both short and extended APDU encodings
+__Z_INLINE uint32_t chunk_data_offset(uint32_t rx) {
+    if (!EXT_APDU_SUPPORTED || rx <= OFFSET_EXT_DATA || G_io_apdu_buffer[APDU_OFFSET_LC] != 0) {
+        return OFFSET_DATA;
+    }
+
+    const uint32_t extLen = ((uint32_t)G_io_apdu_buffer[OFFSET_DATA] << 8) | G_io_apdu_buffer[OFFSET_DATA + 1];
+    if (extLen != rx - OFFSET_EXT_DATA) {
+        THROW(APDU_CODE_WRONG_LENGTH);
+    }
+    return OFFSET_EXT_DATA;
+}
+
+__Z_INLINE void append_chunk(uint32_t dataOffset, uint32_t dataLen) {
+    if (!upload_streamed) {
+        const uint32_t added = tx_append(&(G_io_apdu_buffer[dataOffset]), dataLen);
+        if (added != dataLen) {
+            tx_initialized = false;
+            THROW(APDU_CODE_OUTPUT_BUFFER_TOO_SMALL);
+        }
+        return;
+    }
+
+    const uint8_t p2 = G_io_apdu_buffer[OFFSET_P2];
+    uint8_t flags = 0;
+    if ((p2 & P2_SECTION_START) != 0) {
+        flags |= TX_STREAM_SECTION_START;
+    }
+    if ((p2 & P2_SECTION_KEEP) != 0) {
+        flags |= TX_STREAM_KEEP_BODY;
+    }
+    const zxerr_t err = tx_append_stream(&(G_io_apdu_buffer[dataOffset]), dataLen, flags);
+    if (err != zxerr_ok) {
+        tx_initialized = false;
+        THROW(err == zxerr_buffer_too_small ? APDU_CODE_OUTPUT_BUFFER_TOO_SMALL : APDU_CODE_DATA_INVALID);
+    }
 }
 
-__Z_INLINE bool process_chunk(__Z_UNUSED volatile uint32_t *tx, uint32_t rx) {
+// Shared upload state machine for INS_SIGN and INS_SIGN_MASP. Chunks are only accepted for the
+// instruction that initialized the upload, and P1_UPLOAD_STATUS reports how many bytes were received
+// so a client can resume after a transport error instead of starting again from P1_INIT.
+// With P2_STREAM set on P1_INIT the transaction is streamed through tx_append_stream, see tx_stream.h.
+// Only INS_SIGN accepts a streamed upload.
+__Z_INLINE bool process_chunk(volatile uint32_t *tx, uint32_t rx) {
     const uint8_t payloadType = G_io_apdu_buffer[OFFSET_PAYLOAD_TYPE];
+    const uint8_t ins = G_io_apdu_buffer[OFFSET_INS];
     if (rx < OFFSET_DATA) {
         THROW(APDU_CODE_WRONG_LENGTH);
     }
 
-    uint32_t added;
+    if (payloadType != P1_INIT && (!tx_initialized || upload_ins != ins)) {
+        THROW(APDU_CODE_TX_NOT_INITIALIZED);
+    }
+
+    const uint32_t dataOffset = chunk_data_offset(rx);
+    const uint32_t dataLen = rx - dataOffset;
+
     switch (payloadType) {
         case P1_INIT:
             tx_initialize();
             tx_reset();
-            extractHDPath(rx, OFFSET_DATA);
+            extractHDPath(rx, dataOffset);
+            upload_streamed = (G_io_apdu_buffer[OFFSET_P2] & P2_STREAM) != 0;
+            // MASP signing hashes the uploaded buffer, which a stream would have compacted
+            if (upload_streamed && ins == INS_SIGN_MASP) {
+                THROW(APDU_CODE_INVALIDP1P2);
+            }
+            if (upload_streamed && tx_begin_stream() != zxerr_ok) {
+                THROW(APDU_CODE_EXECUTION_ERROR);
+            }
+            upload_ins = ins;
             tx_initialized = true;
             return false;
         case P1_ADD:
-            if (!tx_initialized) {
-                THROW(APDU_CODE_TX_NOT_INITIALIZED);
-            }
-            added = tx_append(&(G_io_apdu_buffer[OFFSET_DATA]), rx - OFFSET_DATA);
-            if (added != rx - OFFSET_DATA) {
-                tx_initialized = false;
-                THROW(APDU_CODE_OUTPUT_BUFFER_TOO_SMALL);
-            }
+            append_chunk(dataOffset, dataLen);
             return false;
         case P1_LAST:
-            if (!tx_initialized) {
-                THROW(APDU_CODE_TX_NOT_INITIALIZED);
-            }
-            added = tx_append(&(G_io_apdu_buffer[OFFSET_DATA]), rx - OFFSET_DATA);
+            append_chunk(dataOffset, dataLen);
             tx_initialized = false;
-            if (added != rx - OFFSET_DATA) {
-                tx_initialized = false;
-                THROW(APDU_CODE_OUTPUT_BUFFER_TOO_SMALL);
+            if (upload_streamed && tx_end_stream() != zxerr_ok) {
+                THROW(APDU_CODE_DATA_INVALID);
             }
-            tx_initialized = false;
             return true;
+        case P1_UPLOAD_STATUS: {
+            const uint32_t received = upload_streamed ? tx_get_stream_received() : tx_get_buffer_length();
+            G_io_apdu_buffer[0] = (received >> 24) & 0xFF;
+            G_io_apdu_buffer[1] = (received >> 16) & 0xFF;
+            G_io_apdu_buffer[2] = (received >> 8) & 0xFF;
+            G_io_apdu_buffer[3] = (received >> 0) & 0xFF;
+            *tx += 4;
+            THROW(APDU_CODE_OK);
+        }
     }
 
     THROW(APDU_CODE_INVALIDP1P2);
 }
 
-__Z_INLINE void handleSignTransaction(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
-    ZEMU_LOGF(50, "handleSignTransaction\n")
-    if (!process_chunk(tx, rx)) {
-        THROW(APDU_CODE_OK);
-    }
-    CHECK_APP_CANARY()
-
+__Z_INLINE void parseTransaction(volatile uint32_t *tx) {
     const char *error_msg = tx_parse();
     CHECK_APP_CANARY()
 
@@ -116,13 +185,29 @@ __Z_INLINE void handleSignTransaction(volatile uint32_t *flags, volatile uint32_
         *tx += (error_msg_length);
         THROW(APDU_CODE_DATA_INVALID);
     }
+}
+
+__Z_INLINE void handleSign(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx, viewfunc_accept_t accept) {
+    if (!process_chunk(tx, rx)) {
+        THROW(APDU_CODE_OK);
+    }
+    CHECK_APP_CANARY()
+
+    parseTransaction(tx);
 
     CHECK_APP_CANARY()
-    view_review_init(tx_getItem, tx_getNumItems, app_sign);
+    view_review_init(tx_getItem, tx_getNumItems, accept);
     view_review_show(REVIEW_TXN);
     *flags |= IO_ASYNCH_REPLY;
 }
 
+__Z_INLINE void handleSignTransaction(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
+    ZEMU_LOGF(50, "handleSignTransaction\n")
+    handleSign(flags, tx, rx, app_sign);
+}
+
+// Keys are derived and the transaction is checked before the review, so an
+// invalid transaction is rejected right away and approval only signs the spends
 __Z_INLINE void handleSignMasp(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
     ZEMU_LOGF(50, "handleSignMasp\n")
     if (!process_chunk(tx, rx)) {
@@ -130,13 +215,10 @@ __Z_INLINE void handleSignMasp(volatile uint32_t *flags, volatile uint32_t *tx,
     }
     CHECK_APP_CANARY()
 
-    const char *error_msg = tx_parse();
-    CHECK_APP_CANARY()
+    parseTransaction(tx);
 
-    if (error_msg != NULL) {
-        const int error_msg_length = strnlen(error_msg, sizeof(G_io_apdu_buffer));
-        memcpy(G_io_apdu_buffer, error_msg, error_msg_length);
-        *tx += (error_msg_length);
+    if (crypto_prepare_masp(tx_get_txObject()) != zxerr_ok) {
+        transaction_reset();
         THROW(APDU_CODE_DATA_INVALID);
     }
 
@@ -250,6 +332,30 @@ __Z_INLINE void handle_getversion(__Z_UNUSED volatile uint32_t *flags, volatile
     THROW(APDU_CODE_OK);
 }
 
+// Reports the chunk sizes and transaction limits accepted by INS_SIGN and INS_SIGN_MASP
+__Z_INLINE void handleGetCapabilities(__Z_UNUSED volatile uint32_t *flags, volatile uint32_t *tx)
+{
+    const uint16_t maxChunkPayload = MAX_CHUNK_PAYLOAD;
+    const uint32_t txBufferSize = tx_get_buffer_capacity();
+
+    G_io_apdu_buffer[0] = (maxChunkPayload >> 8) & 0xFF;
+    G_io_apdu_buffer[1] = (maxChunkPayload >> 0) & 0xFF;
+    G_io_apdu_buffer[2] = EXT_APDU_SUPPORTED ? 1 : 0;
+
+    G_io_apdu_buffer[3] = (txBufferSize >> 24) & 0xFF;
+    G_io_apdu_buffer[4] = (txBufferSize >> 16) & 0xFF;
+    G_io_apdu_buffer[5] = (txBufferSize >> 8) & 0xFF;
+    G_io_apdu_buffer[6] = (txBufferSize >> 0) & 0xFF;
+
+    G_io_apdu_buffer[7] = MAX_EXTRA_DATA_SECS;
+    G_io_apdu_buffer[8] = MAX_SIGNATURE_SECS;
+    G_io_apdu_buffer[9] = SPEND_LIST_SIZE;
+    G_io_apdu_buffer[10] = FEATURE_SIGN_MASP | FEATURE_UPLOAD_RESUME | FEATURE_STREAMED_UPLOAD;
+
+    *tx += 11;
+    THROW(APDU_CODE_OK);
+}
+
 #if defined(APP_TESTING)
 void handleTest(__Z_UNUSED volatile uint32_t *flags, __Z_UNUSED volatile uint32_t *tx, __Z_UNUSED uint32_t rx) {
     THROW(APDU_CODE_OK);
@@ -277,6 +383,11 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                     break;
                 }
 
+                case INS_GET_CAPABILITIES: {
+                    handleGetCapabilities(flags, tx);
+                    break;
+                }
+
                 case INS_GET_ADDR: {
                     CHECK_PIN_VALIDATED()
                     handleGetAddr(flags, tx, rx);
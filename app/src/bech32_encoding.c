@@ -36,7 +36,8 @@ static uint32_t bech32_final_constant(bech32_encoding enc) {
 
 static const char* charset = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
 
-static int bech32_encode_large(char *output, const char *hrp, const uint8_t *data, size_t data_len, bech32_encoding enc) {
+// Checksum state after the HRP and its separator, returns 0 if the HRP is not valid
+static int bech32_prefix_checksum(const char *hrp, size_t *hrp_len, uint32_t *chk_out) {
     uint32_t chk = 1;
     size_t i = 0;
     while (hrp[i] != 0) {
@@ -49,13 +50,17 @@ static int bech32_encode_large(char *output, const char *hrp, const uint8_t *dat
         chk = bech32_polymod_step(chk) ^ (ch >> 5u);
         ++i;
     }
-    if (i + 7 + data_len > 2*MAX_SIZE) return 0;
     chk = bech32_polymod_step(chk);
-    while (*hrp != 0) {
-        chk = bech32_polymod_step(chk) ^ (*hrp & 0x1fu);
-        *(output++) = *(hrp++);
+    for (size_t j = 0; j < i; ++j) {
+        chk = bech32_polymod_step(chk) ^ (hrp[j] & 0x1fu);
     }
-    *(output++) = '1';
+    *hrp_len = i;
+    *chk_out = chk;
+    return 1;
+}
+
+static int bech32_encode_data(char *output, uint32_t chk, const uint8_t *data, size_t data_len, bech32_encoding enc) {
+    size_t i = 0;
     for (i = 0; i < data_len; ++i) {
         if (*data >> 5u) return 0;
         chk = bech32_polymod_step(chk) ^ (*data);
@@ -72,6 +77,17 @@ static int bech32_encode_large(char *output, const char *hrp, const uint8_t *dat
     return 1;
 }
 
+static int bech32_encode_large(char *output, const char *hrp, const uint8_t *data, size_t data_len, bech32_encoding enc) {
+    uint32_t chk = 1;
+    size_t hrp_len = 0;
+    if (!bech32_prefix_checksum(hrp, &hrp_len, &chk)) return 0;
+    if (hrp_len + 7 + data_len > 2*MAX_SIZE) return 0;
+    MEMCPY(output, hrp, hrp_len);
+    output += hrp_len;
+    *(output++) = '1';
+    return bech32_encode_data(output, chk, data, data_len, enc);
+}
+
 static int convert_bits(uint8_t* out, size_t* outlen, int outBits, const uint8_t* in, size_t inLen, int inBits, int pad) {
     uint32_t val = 0;
     int bits = 0;
@@ -130,3 +146,59 @@ zxerr_t bech32EncodeFromLargeBytes(char *out,
 
     return zxerr_ok;
 }
+
+zxerr_t bech32PrefixInit(bech32_prefix_t *prefix, const char *hrp) {
+    if (prefix == NULL || hrp == NULL) {
+        return zxerr_no_data;
+    }
+
+    size_t hrp_len = 0;
+    uint32_t chk = 1;
+    if (!bech32_prefix_checksum(hrp, &hrp_len, &chk) || hrp_len == 0 || hrp_len > UINT8_MAX) {
+        return zxerr_encoding_failed;
+    }
+    prefix->hrp = hrp;
+    prefix->hrpLen = (uint8_t)hrp_len;
+    prefix->chk = chk;
+    return zxerr_ok;
+}
+
+zxerr_t bech32EncodeWithPrefix(char *out,
+                               size_t out_len,
+                               const bech32_prefix_t *prefix,
+                               const uint8_t *in,
+                               size_t in_len,
+                               uint8_t pad,
+                               bech32_encoding enc) {
+    if (out == NULL || prefix == NULL || prefix->hrp == NULL || in == NULL) {
+        return zxerr_no_data;
+    }
+    MEMZERO(out, out_len);
+
+    if (in_len > MAX_SIZE) {
+        return zxerr_out_of_bounds;
+    }
+
+    // Same lower bound as bech32EncodeFromLargeBytes
+    if (out_len < prefix->hrpLen + (in_len * 2) + 7) {
+        return zxerr_buffer_too_small;
+    }
+
+    uint8_t tmp_data[MAX_SIZE * 2];
+    size_t tmp_size = 0;
+    MEMZERO(tmp_data, sizeof(tmp_data));
+
+    convert_bits(tmp_data, &tmp_size, 5, in, in_len, 8, pad);
+    // HRP, separator, data, checksum and terminator
+    if (prefix->hrpLen + 1 + tmp_size + 6 >= out_len) {
+        return zxerr_buffer_too_small;
+    }
+
+    MEMCPY(out, prefix->hrp, prefix->hrpLen);
+    out[prefix->hrpLen] = '1';
+    if (!bech32_encode_data(out + prefix->hrpLen + 1, prefix->chk, tmp_data, tmp_size, enc)) {
+        return zxerr_encoding_failed;
+    }
+
+    return zxerr_ok;
+}
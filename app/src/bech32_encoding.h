@@ -24,6 +24,13 @@ extern "C" {
 #include <stddef.h>
 #include "bech32.h"
 
+// An HRP and the checksum state after it, so encoding only runs the polymod over the data
+typedef struct {
+    const char *hrp;
+    uint8_t hrpLen;
+    uint32_t chk;
+} bech32_prefix_t;
+
 zxerr_t bech32EncodeFromLargeBytes(char *out,
                               size_t out_len,
                               const char *hrp,
@@ -32,6 +39,16 @@ zxerr_t bech32EncodeFromLargeBytes(char *out,
                               uint8_t pad,
                               bech32_encoding enc);
 
+zxerr_t bech32PrefixInit(bech32_prefix_t *prefix, const char *hrp);
+
+zxerr_t bech32EncodeWithPrefix(char *out,
+                               size_t out_len,
+                               const bech32_prefix_t *prefix,
+                               const uint8_t *in,
+                               size_t in_len,
+                               uint8_t pad,
+                               bech32_encoding enc);
+
 #ifdef __cplusplus
 }
 #endif
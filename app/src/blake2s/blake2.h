@@ -99,6 +99,7 @@ extern "C" {
   int blake2sp_init( blake2sp_state *S, size_t outlen );
   int blake2sp_init_key( blake2sp_state *S, size_t outlen, const void *key, size_t keylen );
   int blake2s_init_with_personalization( blake2s_state *S, size_t outlen, const uint8_t* personalization, uint8_t personalizationlen );
+  int blake2s_init_from_midstate( blake2s_state *S, size_t outlen, const uint32_t h[8], uint32_t compressed );
   int blake2sp_update( blake2sp_state *S, const void *in, size_t inlen );
   int blake2sp_final( blake2sp_state *S, void *out, size_t outlen );
 
@@ -140,6 +140,19 @@ int blake2s_init_with_personalization( blake2s_state *S, size_t outlen, const ui
   return blake2s_init_param( S, P );
 }
 
+/* Resume hashing from the chaining value left after compressing the first `compressed` bytes */
+int blake2s_init_from_midstate( blake2s_state *S, size_t outlen, const uint32_t h[8], uint32_t compressed )
+{
+  if ( ( !outlen ) || ( outlen > BLAKE2S_OUTBYTES ) ) return -1;
+  if ( ( !h ) || ( !compressed ) || ( compressed % BLAKE2S_BLOCKBYTES ) ) return -1;
+
+  memset( S, 0, sizeof( blake2s_state ) );
+  memcpy( S->h, h, sizeof( S->h ) );
+  S->t[0] = compressed;
+  S->outlen = outlen;
+  return 0;
+}
+
 int blake2s_init_key( blake2s_state *S, size_t outlen, const void *key, size_t keylen )
 {
   blake2s_param P[1];
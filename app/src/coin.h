@@ -107,6 +107,21 @@ typedef enum {
 #define INS_GET_CONVERT_RAND            0x06
 #define INS_SIGN_MASP                   0x07
 #define INS_EXTRACT_SPEND_SIGN          0x08
+#define INS_GET_CAPABILITIES            0x09
+
+// Payload type used by INS_SIGN and INS_SIGN_MASP to query the upload progress
+#define P1_UPLOAD_STATUS                0x03
+
+// P2 flags for streamed uploads: set on P1_INIT to stream the transaction, then on the
+// chunks that start a section. P2_SECTION_KEEP keeps the body of that section inline.
+#define P2_STREAM                       0x01
+#define P2_SECTION_START                0x01
+#define P2_SECTION_KEEP                 0x02
+
+// Optional features reported by INS_GET_CAPABILITIES
+#define FEATURE_SIGN_MASP               0x01
+#define FEATURE_UPLOAD_RESUME           0x02
+#define FEATURE_STREAMED_UPLOAD         0x04
 
 #define APDU_CODE_CHECK_SIGN_TR_FAIL 0x6999
 #ifdef __cplusplus
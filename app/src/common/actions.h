@@ -126,6 +126,7 @@ __Z_INLINE void app_sign_masp() {
 }
 
 __Z_INLINE void app_reject() {
+    crypto_clear_masp();
     transaction_reset();
     MEMZERO(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE);
     set_code(G_io_apdu_buffer, 0, APDU_CODE_COMMAND_NOT_ALLOWED);
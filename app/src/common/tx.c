@@ -18,6 +18,7 @@
 #include "apdu_codes.h"
 #include "buffering.h"
 #include "parser.h"
+#include "tx_stream.h"
 #include <string.h>
 #include "zxmacros.h"
 
@@ -44,6 +45,8 @@ storage_t NV_CONST N_appdata_impl __attribute__((aligned(64)));
 
 static parser_tx_t tx_obj;
 static parser_context_t ctx_parsed_tx;
+static tx_stream_t tx_stream;
+static bool tx_streamed = false;
 
 void tx_initialize() {
     buffering_init(
@@ -55,16 +58,43 @@ void tx_initialize() {
 
 void tx_reset() {
     buffering_reset();
+    tx_streamed = false;
 }
 
 uint32_t tx_append(unsigned char *buffer, uint32_t length) {
     return buffering_append(buffer, length);
 }
 
+static uint32_t tx_stream_write(const uint8_t *data, uint32_t dataLen) {
+    return buffering_append((uint8_t *)data, dataLen);
+}
+
+zxerr_t tx_begin_stream() {
+    CHECK_ZXERR(tx_stream_init(&tx_stream, tx_stream_write))
+    tx_streamed = true;
+    return zxerr_ok;
+}
+
+zxerr_t tx_append_stream(const uint8_t *buffer, uint32_t length, uint8_t flags) {
+    return tx_stream_update(&tx_stream, buffer, length, flags);
+}
+
+zxerr_t tx_end_stream() {
+    return tx_stream_final(&tx_stream);
+}
+
+uint32_t tx_get_stream_received() {
+    return tx_stream.received;
+}
+
 uint32_t tx_get_buffer_length() {
     return buffering_get_buffer()->pos;
 }
 
+uint32_t tx_get_buffer_capacity() {
+    return FLASH_BUFFER_SIZE;
+}
+
 uint8_t *tx_get_buffer() {
     return buffering_get_buffer()->data;
 }
@@ -75,6 +105,7 @@ parser_tx_t* tx_get_txObject() {
 
 const char *tx_parse() {
     MEMZERO(&tx_obj, sizeof(tx_obj));
+    tx_obj.transaction.streamed = tx_streamed;
 
     uint8_t err = parser_parse(
             &ctx_parsed_tx,
@@ -95,6 +126,13 @@ const char *tx_parse() {
         return parser_getErrorDescription(err);
     }
 
+    // The stream does not know which extra data section is the memo, reject it if the stream
+    // compacted it, as it would only be shown as a hash
+    const section_t *memo = tx_obj.transaction.header.memoSection;
+    if (tx_streamed && memo != NULL && tx_stream_compacted(&tx_stream, memo->idx)) {
+        return "Memo not kept inline";
+    }
+
     return NULL;
 }
 
@@ -32,10 +32,30 @@ void tx_reset();
 /// \return It returns an error message if the buffer is too small.
 uint32_t tx_append(unsigned char *buffer, uint32_t length);
 
+/// Starts a streamed upload, see tx_stream.h
+zxerr_t tx_begin_stream();
+
+/// Appends streamed transaction bytes, compacting large code and extra data bodies
+/// \param buffer
+/// \param length
+/// \param sectionStart the bytes begin a new section
+/// \return zxerr_buffer_too_small if the compacted transaction does not fit
+zxerr_t tx_append_stream(const uint8_t *buffer, uint32_t length, uint8_t flags);
+
+/// Checks that the streamed upload did not stop in the middle of a section
+zxerr_t tx_end_stream();
+
+/// Returns the number of streamed bytes received, before compaction
+uint32_t tx_get_stream_received();
+
 /// Returns size of the raw json transaction buffer
 /// \return
 uint32_t tx_get_buffer_length();
 
+/// Returns the largest transaction that fits in the transaction buffer
+/// \return
+uint32_t tx_get_buffer_capacity();
+
 /// Returns the raw json transaction buffer
 /// \return
 uint8_t *tx_get_buffer();
@@ -27,6 +27,7 @@
 #include "parser_impl_common.h"
 #include "parser_impl_masp.h"
 #include "signhash.h"
+#include "hashing.h"
 #include "rslib.h"
 #include "keys_def.h"
 #include "keys_personalizations.h"
@@ -57,6 +58,13 @@
     }                          \
   } while (0)
 
+#define CATCH_PARSER_ERROR(CALL)         \
+  do {                                   \
+    if ((CALL) != parser_ok) {           \
+      goto catch_parser_error;           \
+    }                                    \
+  } while (0)
+
 static zxerr_t crypto_extractPublicKey_ed25519(uint8_t *pubKey, uint16_t pubKeyLen) {
     if (pubKey == NULL || pubKeyLen < PK_LEN_25519) {
         return zxerr_invalid_crypto_settings;
@@ -183,12 +191,12 @@ static zxerr_t crypto_hashFeeHeader(const header_t *header, uint8_t *output, uin
     if (header == NULL || output == NULL || outputLen < CX_SHA256_SIZE) {
          return zxerr_invalid_crypto_settings;
     }
-    cx_sha256_t sha256 = {0};
-    cx_sha256_init(&sha256);
+    hash_sha256_t sha256;
+    CHECK_ZXERR(hash_sha256_init(&sha256))
     const uint8_t discriminant = DISCRIMINANT_HEADER;
-    CHECK_CX_OK(cx_sha256_update(&sha256, &discriminant, sizeof(discriminant)));
-    CHECK_CX_OK(cx_sha256_update(&sha256, header->extBytes.ptr, header->extBytes.len));
-    CHECK_CX_OK(cx_sha256_final(&sha256, output));
+    CHECK_ZXERR(hash_sha256_update(&sha256, &discriminant, sizeof(discriminant)))
+    CHECK_ZXERR(hash_sha256_update(&sha256, header->extBytes.ptr, header->extBytes.len))
+    CHECK_ZXERR(hash_sha256_final(&sha256, output))
     return zxerr_ok;
 }
 
@@ -197,14 +205,14 @@ static zxerr_t crypto_hashRawHeader(const header_t *header, uint8_t *output, uin
     if (header == NULL || output == NULL || outputLen < CX_SHA256_SIZE) {
          return zxerr_invalid_crypto_settings;
     }
-    cx_sha256_t sha256 = {0};
-    cx_sha256_init(&sha256);
+    hash_sha256_t sha256;
+    CHECK_ZXERR(hash_sha256_init(&sha256))
     const uint8_t discriminant = DISCRIMINANT_HEADER;
-    CHECK_CX_OK(cx_sha256_update(&sha256, &discriminant, sizeof(discriminant)));
-    CHECK_CX_OK(cx_sha256_update(&sha256, header->bytes.ptr, header->bytes.len));
+    CHECK_ZXERR(hash_sha256_update(&sha256, &discriminant, sizeof(discriminant)))
+    CHECK_ZXERR(hash_sha256_update(&sha256, header->bytes.ptr, header->bytes.len))
     const uint8_t header_discriminant = 0x00;
-    CHECK_CX_OK(cx_sha256_update(&sha256, &header_discriminant, sizeof(header_discriminant)));
-    CHECK_CX_OK(cx_sha256_final(&sha256, output));
+    CHECK_ZXERR(hash_sha256_update(&sha256, &header_discriminant, sizeof(header_discriminant)))
+    CHECK_ZXERR(hash_sha256_final(&sha256, output))
     return zxerr_ok;
 }
 
@@ -213,18 +221,18 @@ zxerr_t crypto_hashSigSection(const signature_section_t *signature_section, cons
          return zxerr_invalid_crypto_settings;
     }
 
-    cx_sha256_t sha256 = {0};
-    cx_sha256_init(&sha256);
+    hash_sha256_t sha256;
+    CHECK_ZXERR(hash_sha256_init(&sha256))
     if (prefix != NULL) {
-        CHECK_CX_OK(cx_sha256_update(&sha256, prefix, prefixLen));
+        CHECK_ZXERR(hash_sha256_update(&sha256, prefix, prefixLen))
     }
-    CHECK_CX_OK(cx_sha256_update(&sha256, (uint8_t*) &signature_section->hashes.hashesLen, 4));
-    CHECK_CX_OK(cx_sha256_update(&sha256, signature_section->hashes.hashes.ptr, HASH_LEN * signature_section->hashes.hashesLen));
-    CHECK_CX_OK(cx_sha256_update(&sha256, (uint8_t*) &signature_section->signerDiscriminant, 1));
+    CHECK_ZXERR(hash_sha256_update(&sha256, (uint8_t*) &signature_section->hashes.hashesLen, 4))
+    CHECK_ZXERR(hash_sha256_update(&sha256, signature_section->hashes.hashes.ptr, HASH_LEN * signature_section->hashes.hashesLen))
+    CHECK_ZXERR(hash_sha256_update(&sha256, (uint8_t*) &signature_section->signerDiscriminant, 1))
 
     switch (signature_section->signerDiscriminant) {
         case PubKeys: {
-            CHECK_CX_OK(cx_sha256_update(&sha256, (uint8_t*) &signature_section->pubKeysLen, 4));
+            CHECK_ZXERR(hash_sha256_update(&sha256, (uint8_t*) &signature_section->pubKeysLen, 4))
             uint32_t pos = 0;
             for (uint32_t i = 0; i < signature_section->pubKeysLen; i++) {
                 uint8_t tag = signature_section->pubKeys.ptr[pos++];
@@ -237,19 +245,19 @@ zxerr_t crypto_hashSigSection(const signature_section_t *signature_section, cons
                 pos += pubKeySize;
             }
             if(pos > 0) {
-                CHECK_CX_OK(cx_sha256_update(&sha256, signature_section->pubKeys.ptr, pos));
+                CHECK_ZXERR(hash_sha256_update(&sha256, signature_section->pubKeys.ptr, pos))
             }
             break;
         }
         case Address:
-            CHECK_CX_OK(cx_sha256_update(&sha256, signature_section->addressBytes.ptr, signature_section->addressBytes.len));
+            CHECK_ZXERR(hash_sha256_update(&sha256, signature_section->addressBytes.ptr, signature_section->addressBytes.len))
             break;
 
         default:
             return zxerr_invalid_crypto_settings;
     }
 
-    CHECK_CX_OK(cx_sha256_update(&sha256, (const uint8_t*) &signature_section->signaturesLen, 4));
+    CHECK_ZXERR(hash_sha256_update(&sha256, (const uint8_t*) &signature_section->signaturesLen, 4))
     uint32_t pos = 0;
     for (uint32_t i = 0; i < signature_section->signaturesLen; i++) {
         // Skip the signature's 1 byte index
@@ -264,9 +272,9 @@ zxerr_t crypto_hashSigSection(const signature_section_t *signature_section, cons
         pos += signatureSize;
     }
     if(pos > 0) {
-        CHECK_CX_OK(cx_sha256_update(&sha256, signature_section->indexedSignatures.ptr, pos));
+        CHECK_ZXERR(hash_sha256_update(&sha256, signature_section->indexedSignatures.ptr, pos))
     }
-    CHECK_CX_OK(cx_sha256_final(&sha256, output));
+    CHECK_ZXERR(hash_sha256_final(&sha256, output))
     return zxerr_ok;
 }
 
@@ -477,29 +485,77 @@ zxerr_t crypto_sign(const parser_tx_t *txObj, uint8_t *output, uint16_t outputLe
 }
 
 // MASP
-static zxerr_t computeKeys(keys_t * saplingKeys) {
+// One-way tag of the account for the diversifier cache. dk is included so the
+// same path under another seed or passphrase does not hit a stale entry.
+static zxerr_t diversifierCacheTag(const uint8_t dk[KEY_LENGTH], uint8_t tag[DIVERSIFIER_CACHE_TAG_LEN]) {
+    static const char domain[] = "Namada_DivCache";
+    uint8_t digest[HASH_SHA256_LEN] = {0};
+    hash_sha256_t ctx;
+    CHECK_ZXERR(hash_sha256_init(&ctx))
+    CHECK_ZXERR(hash_sha256_update(&ctx, (const uint8_t *)domain, sizeof(domain) - 1))
+    CHECK_ZXERR(hash_sha256_update(&ctx, (const uint8_t *)hdPath, sizeof(hdPath)))
+    CHECK_ZXERR(hash_sha256_update(&ctx, dk, KEY_LENGTH))
+    CHECK_ZXERR(hash_sha256_final(&ctx, digest))
+    MEMCPY(tag, digest, DIVERSIFIER_CACHE_TAG_LEN);
+    return zxerr_ok;
+}
+
+// The default address uses the first valid diversifier from index 0. Its index
+// is cached per account, so later requests start the search right at it.
+static zxerr_t computeDefaultDiversifier(keys_t *saplingKeys, gd_t g_d) {
+    const d_t zero_index = {0};
+    if (MEMCMP(saplingKeys->diversifier_start_index, zero_index, DIVERSIFIER_LENGTH) != 0) {
+        CHECK_PARSER_OK(computeDiversifier(saplingKeys->dk, saplingKeys->diversifier_start_index, saplingKeys->diversifier, g_d));
+        return zxerr_ok;
+    }
+
+    uint8_t tag[DIVERSIFIER_CACHE_TAG_LEN] = {0};
+    d_t index = {0};
+    d_t found_index = {0};
+    CHECK_ZXERR(diversifierCacheTag(saplingKeys->dk, tag))
+    diversifier_cache_lookup(tag, index);
+
+    CHECK_PARSER_OK(computeDiversifierWithIndex(saplingKeys->dk, index, saplingKeys->diversifier, g_d, found_index));
+    diversifier_cache_store(tag, found_index);
+    return zxerr_ok;
+}
+
+// Only derive what the requested key kind returns: the proof generation key
+// stops at ak, view keys stop at ivk and only the address needs the diversifier and pkd
+static zxerr_t computeKeys(keys_t * saplingKeys, key_kind_e requestedKeys) {
     if (saplingKeys == NULL) {
         return zxerr_no_data;
     }
 
-    // Compute ask, nsk, ovk
+    // Compute ask, nsk
     CHECK_PARSER_OK(convertKey(saplingKeys->spendingKey, MODIFIER_ASK, saplingKeys->ask, true));
     CHECK_PARSER_OK(convertKey(saplingKeys->spendingKey, MODIFIER_NSK, saplingKeys->nsk, true));
-    CHECK_PARSER_OK(convertKey(saplingKeys->spendingKey, MODIFIER_OVK, saplingKeys->ovk, true));
 
-    // Compute diversifier key - dk
-    CHECK_PARSER_OK(convertKey(saplingKeys->spendingKey, MODIFIER_DK, saplingKeys->dk, true));
+    if (requestedKeys == ProofGenerationKey) {
+        CHECK_PARSER_OK(generate_key(saplingKeys->ask, SpendingKeyGenerator, saplingKeys->ak));
+        return zxerr_ok;
+    }
+
+    // Compute ovk
+    CHECK_PARSER_OK(convertKey(saplingKeys->spendingKey, MODIFIER_OVK, saplingKeys->ovk, true));
 
     // Compute ak, nk, ivk
-    CHECK_PARSER_OK(generate_key(saplingKeys->ask, SpendingKeyGenerator, saplingKeys->ak));
-    CHECK_PARSER_OK(generate_key(saplingKeys->nsk, ProofGenerationKeyGenerator, saplingKeys->nk));
+    CHECK_PARSER_OK(computeAkNk(saplingKeys->ask, saplingKeys->nsk, saplingKeys->ak, saplingKeys->nk));
     CHECK_PARSER_OK(computeIVK(saplingKeys->ak, saplingKeys->nk, saplingKeys->ivk));
 
-    // Compute diversifier
-    CHECK_PARSER_OK(computeDiversifier(saplingKeys->dk, saplingKeys->diversifier_start_index, saplingKeys->diversifier));
+    if (requestedKeys == ViewKeys) {
+        return zxerr_ok;
+    }
+
+    // Compute diversifier key - dk
+    CHECK_PARSER_OK(convertKey(saplingKeys->spendingKey, MODIFIER_DK, saplingKeys->dk, true));
+
+    // Compute diversifier, keeping its group hash for the address
+    gd_t g_d = {0};
+    CHECK_ZXERR(computeDefaultDiversifier(saplingKeys, g_d));
 
     // Compute address
-    CHECK_PARSER_OK(computePkd(saplingKeys->ivk, saplingKeys->diversifier, saplingKeys->address));
+    CHECK_PARSER_OK(computePkdFromGd(saplingKeys->ivk, g_d, saplingKeys->address));
 
     return zxerr_ok;
 }
@@ -585,7 +641,7 @@ zxerr_t crypto_generateSaplingKeys(uint8_t *output, uint16_t outputLen, key_kind
         return zxerr_unknown;
     }
 
-    error = computeKeys(&saplingKeys);
+    error = computeKeys(&saplingKeys, requestedKey);
 
     // Copy keys
     if (error == zxerr_ok) {
@@ -594,6 +650,7 @@ zxerr_t crypto_generateSaplingKeys(uint8_t *output, uint16_t outputLen, key_kind
 
     MEMZERO(sk, sizeof(sk));
     MEMZERO(&saplingKeys, sizeof(saplingKeys));
+    clear_diversifier_generator();
     return error;
 }
 
@@ -629,95 +686,101 @@ static parser_error_t h_star(uint8_t *a, uint16_t a_len, uint8_t *b, uint16_t b_
         return parser_no_data;
     }
 
-    uint8_t hash[BLAKE2B_OUTPUT_LEN] = {0};
-#if defined(LEDGER_SPECIFIC)
-    cx_blake2b_t ctx = {0};
-    ASSERT_CX_OK(cx_blake2b_init2_no_throw(&ctx, BLAKE2B_OUTPUT_LEN, NULL, 0, (uint8_t *)SINGNING_REGJUBJUB,
-                                           sizeof(SINGNING_REGJUBJUB)));
-    ASSERT_CX_OK(cx_blake2b_update(&ctx, a, a_len));
-    ASSERT_CX_OK(cx_blake2b_update(&ctx, b, b_len));
-    cx_blake2b_final(&ctx, hash);
-#else
-    blake2b_state state = {0};
-    blake2b_init_with_personalization(&state, BLAKE2B_OUTPUT_LEN, (const uint8_t *)SINGNING_REGJUBJUB,
-                                      sizeof(SINGNING_REGJUBJUB));
-    blake2b_update(&state, a, a_len);
-    blake2b_update(&state, b, b_len);
-    blake2b_final(&state, hash, BLAKE2B_OUTPUT_LEN);
-#endif
+    uint8_t hash[HASH_BLAKE2B_MAX_LEN] = {0};
+    hash_blake2b_t ctx;
+    ASSERT_HASH_OK(hash_blake2b_init(&ctx, sizeof(hash), (const uint8_t *)SINGNING_REGJUBJUB,
+                                     sizeof(SINGNING_REGJUBJUB)));
+    ASSERT_HASH_OK(hash_blake2b_update(&ctx, a, a_len));
+    ASSERT_HASH_OK(hash_blake2b_update(&ctx, b, b_len));
+    ASSERT_HASH_OK(hash_blake2b_final(&ctx, hash));
 
     from_bytes_wide(hash, output);
 
     return parser_ok;
 }
-static zxerr_t sign_sapling_spend(keys_t *keys, uint8_t alpha[static KEY_LENGTH], uint8_t sign_hash[static KEY_LENGTH], uint8_t *signature) {
-    if (alpha == NULL || sign_hash == NULL || signature == NULL) {
+static zxerr_t sign_sapling_spend(const rs_scalar_t *ask, uint8_t alpha[static KEY_LENGTH], uint8_t sign_hash[static KEY_LENGTH], uint8_t *signature) {
+    if (ask == NULL || alpha == NULL || sign_hash == NULL || signature == NULL) {
         return zxerr_no_data;
     }
 
+    zxerr_t error = zxerr_unknown;
     uint8_t data_to_be_signed[2 * HASH_LEN] = {0};
-    uint8_t rsk[KEY_LENGTH] = {0};
+    rs_scalar_t rsk = {0};
+    uint8_t rsk_bytes[KEY_LENGTH] = {0};
     uint8_t rk[KEY_LENGTH] = {0};
+    uint8_t rng[RNG_LEN] = {0};
+    uint8_t r[32] = {0};
+    uint8_t rbar[32] = {0};
+    uint8_t s[32] = {0};
+    uint8_t sbar[32] = {0};
 
     // get randomized secret
-    randomized_secret_from_seed(keys->ask, alpha, rsk);
+    CATCH_PARSER_ERROR(randomized_secret(ask, alpha, &rsk, rsk_bytes));
 
     //rsk to rk
-    scalar_multiplication(rsk, SpendingKeyGenerator, rk);
+    CATCH_PARSER_ERROR(scalar_multiplication(rsk_bytes, SpendingKeyGenerator, rk));
 
     // sign
     MEMCPY(data_to_be_signed, rk, KEY_LENGTH);
     MEMCPY(data_to_be_signed + KEY_LENGTH, sign_hash, HASH_LEN);
 
     // Get rng
-    uint8_t rng[RNG_LEN] = {0};
     cx_rng_no_throw(rng, RNG_LEN);
 
     // Compute r and rbar
-    uint8_t r[32] = {0};
-    uint8_t rbar[32] = {0};
-    CHECK_PARSER_OK(h_star(rng, sizeof(rng), data_to_be_signed, sizeof(data_to_be_signed), r));
-    CHECK_PARSER_OK(scalar_multiplication(r, SpendingKeyGenerator, rbar));
+    CATCH_PARSER_ERROR(h_star(rng, sizeof(rng), data_to_be_signed, sizeof(data_to_be_signed), r));
+    CATCH_PARSER_ERROR(scalar_multiplication(r, SpendingKeyGenerator, rbar));
 
     //compute s and sbar
-    uint8_t s[32] = {0};
-    uint8_t sbar[32] = {0};
-    CHECK_PARSER_OK(h_star(rbar, sizeof(rbar), data_to_be_signed, sizeof(data_to_be_signed), s));
-    CHECK_PARSER_OK(compute_sbar(s, r, rsk, sbar));
+    CATCH_PARSER_ERROR(h_star(rbar, sizeof(rbar), data_to_be_signed, sizeof(data_to_be_signed), s));
+    CATCH_PARSER_ERROR(compute_sbar(s, r, &rsk, sbar));
 
     MEMCPY(signature, rbar, HASH_LEN);
     MEMCPY(signature + HASH_LEN, sbar, HASH_LEN);
+    error = zxerr_ok;
 
-    return zxerr_ok;
+catch_parser_error:
+    MEMZERO(&rsk, sizeof(rsk));
+    MEMZERO(rsk_bytes, sizeof(rsk_bytes));
+    MEMZERO(rng, sizeof(rng));
+    MEMZERO(r, sizeof(r));
+
+    return error;
 }
 
-zxerr_t crypto_sign_spends_sapling(const parser_tx_t *txObj, keys_t *keys) {
+zxerr_t crypto_sign_spends_sapling(const parser_tx_t *txObj, const rs_scalar_t *ask, uint8_t sign_hash[static HASH_LEN]) {
     zemu_log_stack("crypto_signspends_sapling");
+    if (txObj == NULL || ask == NULL || sign_hash == NULL) {
+        return zxerr_no_data;
+    }
     if (txObj->transaction.sections.maspTx.data.sapling_bundle.n_shielded_spends == 0) {
         return zxerr_ok;
     }
 
-    // Get Signature hash
-    uint8_t sign_hash[HASH_LEN] = {0};
-    signature_hash(txObj, sign_hash);
-
     uint8_t signature[2 * HASH_LEN] = {0};
     const uint8_t *spend = txObj->transaction.sections.maspBuilder.builder.sapling_builder.spends.ptr;
     uint16_t spendLen = 0;
+    zxerr_t err = zxerr_ok;
 
-    for (uint64_t i = 0; i < txObj->transaction.sections.maspBuilder.builder.sapling_builder.n_spends; i++) {
+    for (uint64_t i = 0; i < txObj->transaction.sections.maspBuilder.builder.sapling_builder.n_spends && err == zxerr_ok; i++) {
         // Get spend description and alpha
         spend += spendLen;
         spend_item_t *item = spendlist_retrieve_rand_item(i);
+        if (item == NULL) {
+            return zxerr_no_data;
+        }
 
-        CHECK_ZXERR(sign_sapling_spend(keys, item->alpha, sign_hash, signature));
+        err = sign_sapling_spend(ask, item->alpha, sign_hash, signature);
 
         // Save signature in flash
-        CHECK_ZXERR(spend_signatures_append(signature));
+        if (err == zxerr_ok) {
+            err = spend_signatures_append(signature);
+        }
 
         // Get this spend lenght to get next one
         getSpendDescriptionLen(spend, &spendLen);
     }
+    CHECK_ZXERR(err);
 
     return zxerr_ok;
 }
@@ -733,8 +796,8 @@ zxerr_t crypto_extract_spend_signature(uint8_t *buffer, uint16_t bufferLen, uint
     return get_next_spend_signature(buffer);
 }
 
-parser_error_t checkSpends(const parser_tx_t *txObj, keys_t *keys, parser_context_t *builder_spends_ctx, parser_context_t *tx_spends_ctx) {
-    if (txObj == NULL || keys == NULL) {
+parser_error_t checkSpends(const parser_tx_t *txObj, const rs_scalar_t *ask, parser_context_t *builder_spends_ctx, parser_context_t *tx_spends_ctx) {
+    if (txObj == NULL || ask == NULL) {
         return parser_unexpected_error;
     }
 
@@ -746,6 +809,9 @@ parser_error_t checkSpends(const parser_tx_t *txObj, keys_t *keys, parser_contex
         CHECK_ERROR(getNextSpendDescription(builder_spends_ctx, i));
         CTX_CHECK_AND_ADVANCE(tx_spends_ctx, SHIELDED_SPENDS_LEN * i);
         spend_item_t *item = spendlist_retrieve_rand_item(i);
+        if (item == NULL) {
+            return parser_unexpected_value;
+        }
 
         //check cv computation validaded in cpp_tests
         uint8_t cv[KEY_LENGTH] = {0};
@@ -762,7 +828,7 @@ parser_error_t checkSpends(const parser_tx_t *txObj, keys_t *keys, parser_contex
 
         //check rk
         uint8_t rk[KEY_LENGTH] = {0};
-        CHECK_ERROR(computeRk(keys, item->alpha, rk));
+        CHECK_ERROR(computeRk(ask, item->alpha, rk));
 
         CTX_CHECK_AND_ADVANCE(tx_spends_ctx, CV_LEN + NULLIFIER_LEN);
 #ifndef APP_TESTING
@@ -794,6 +860,9 @@ parser_error_t checkOutputs(const parser_tx_t *txObj, parser_context_t *builder_
 
         CTX_CHECK_AND_ADVANCE(tx_outputs_ctx, SHIELDED_OUTPUTS_LEN * indice);
         output_item_t *item = outputlist_retrieve_rand_item(indice);
+        if (item == NULL) {
+            return parser_unexpected_value;
+        }
 
         //check cv computation validaded in cpp_tests
         uint8_t cv[KEY_LENGTH] = {0};
@@ -849,8 +918,8 @@ parser_error_t checkConverts(const parser_tx_t *txObj, parser_context_t *builder
     return parser_ok;
 }
 
-zxerr_t crypto_check_masp(const parser_tx_t *txObj, keys_t *keys) {
-    if (txObj == NULL || keys == NULL) {
+zxerr_t crypto_check_masp(const parser_tx_t *txObj, const rs_scalar_t *ask) {
+    if (txObj == NULL || ask == NULL) {
         return zxerr_unknown;
     }
 
@@ -864,7 +933,7 @@ zxerr_t crypto_check_masp(const parser_tx_t *txObj, keys_t *keys) {
                                       .bufferLen = txObj->transaction.sections.maspTx.data.sapling_bundle.shielded_spends.len,
                                       .offset = 0, 
                                       .tx_obj = NULL};
-    CHECK_PARSER_OK(checkSpends(txObj, keys, &builder_spends_ctx, &tx_spends_ctx));
+    CHECK_PARSER_OK(checkSpends(txObj, ask, &builder_spends_ctx, &tx_spends_ctx));
 
     // Check outputs
     parser_context_t builder_outputs_ctx = {.buffer = txObj->transaction.sections.maspBuilder.builder.sapling_builder.outputs.ptr,
@@ -903,33 +972,68 @@ zxerr_t crypto_hash_messagebuffer(uint8_t *buffer, uint16_t bufferLen,
   return zxerr_ok;
 }
 
-zxerr_t crypto_sign_masp(const parser_tx_t *txObj, uint8_t *output, uint16_t outputLen) {
-    if (txObj == NULL || output == NULL || outputLen < ED25519_SIGNATURE_SIZE) {
-        return zxerr_unknown;
+// Everything that can be verified before the review: ask is derived, the
+// transaction is checked against the builder data and the sighash is computed.
+// Approval is then only followed by the spend signatures.
+typedef struct {
+    bool ready;
+    rs_scalar_t ask;
+    uint8_t sign_hash[HASH_LEN];
+} masp_signing_t;
+
+static masp_signing_t masp_signing;
+
+void crypto_clear_masp() {
+    MEMZERO(&masp_signing, sizeof(masp_signing));
+}
+
+zxerr_t crypto_prepare_masp(const parser_tx_t *txObj) {
+    crypto_clear_masp();
+    if (txObj == NULL) {
+        return zxerr_no_data;
     }
 
-    // Get keys
+    // Spend authorization only needs ask
     uint8_t sapling_seed[KEY_LENGTH] = {0};
     keys_t keys = {0};
-    CHECK_ZXERR(crypto_computeSaplingSeed(sapling_seed));
-    if (computeMasterFromSeed(sapling_seed, keys.spendingKey)) {
-        MEMZERO(sapling_seed, sizeof(sapling_seed));
+    zxerr_t err = crypto_computeSaplingSeed(sapling_seed);
+    if (err == zxerr_ok && (computeMasterFromSeed(sapling_seed, keys.spendingKey) != parser_ok ||
+                            convertKey(keys.spendingKey, MODIFIER_ASK, keys.ask, true) != parser_ok ||
+                            scalar_from_bytes(keys.ask, &masp_signing.ask) != parser_ok)) {
+        err = zxerr_unknown;
+    }
+    MEMZERO(sapling_seed, sizeof(sapling_seed));
+    MEMZERO(&keys, sizeof(keys));
+
+    if (err == zxerr_ok && crypto_check_masp(txObj, &masp_signing.ask) != zxerr_ok) {
+        err = zxerr_invalid_crypto_settings;
+    }
+    if (err == zxerr_ok && txObj->transaction.sections.maspTx.data.sapling_bundle.n_shielded_spends > 0) {
+        err = signature_hash(txObj, masp_signing.sign_hash);
+    }
+
+    if (err != zxerr_ok) {
+        crypto_clear_masp();
+        return err;
+    }
+    masp_signing.ready = true;
+    return zxerr_ok;
+}
+
+zxerr_t crypto_sign_masp(const parser_tx_t *txObj, uint8_t *output, uint16_t outputLen) {
+    if (txObj == NULL || output == NULL || outputLen < ED25519_SIGNATURE_SIZE || !masp_signing.ready) {
+        crypto_clear_masp();
         return zxerr_unknown;
     }
 
-    if (computeKeys(&keys) != zxerr_ok || crypto_check_masp(txObj, &keys) != zxerr_ok || 
-        crypto_sign_spends_sapling(txObj, &keys) != zxerr_ok) {
-        MEMZERO(sapling_seed, sizeof(sapling_seed));
-        MEMZERO(&keys, sizeof(keys));
+    const zxerr_t err = crypto_sign_spends_sapling(txObj, &masp_signing.ask, masp_signing.sign_hash);
+    crypto_clear_masp();
+    if (err != zxerr_ok) {
         return zxerr_invalid_crypto_settings;
     }
 
     //Hash buffer and retreive for verify purpose
-    zxerr_t err = crypto_hash_messagebuffer(output, outputLen, tx_get_buffer(), tx_get_buffer_length());
-
-    MEMZERO(sapling_seed, sizeof(sapling_seed));
-    MEMZERO(&keys, sizeof(keys));
-    return err;
+    return crypto_hash_messagebuffer(output, outputLen, tx_get_buffer(), tx_get_buffer_length());
 }
 
 static zxerr_t random_fr(uint8_t *buffer, uint16_t bufferLen) {
@@ -14,6 +14,7 @@
 *  limitations under the License.
 ********************************************************************************/
 #include "crypto_helper.h"
+#include <stddef.h>
 #include "coin.h"
 #include "bech32.h"
 #include "zxformat.h"
@@ -40,21 +41,57 @@
 #define TESTNET_EXT_FULL_VIEWING_KEY_HRP "testzvknam"
 #define TESTNET_PAYMENT_ADDR_HRP "testznam"
 
-#if defined(TARGET_NANOS) || defined(TARGET_NANOS2) || defined(TARGET_NANOX) || defined(TARGET_STAX)
-    #include "cx.h"
-    #include "cx_sha256.h"
-    #include "cx_blake2b.h"
-#else
-    #include "picohash.h"
-    #include "blake2.h"
-    #define CX_SHA256_SIZE 32
-#endif
+#include "hashing.h"
 #include "blake2.h"
+#define CX_SHA256_SIZE HASH_SHA256_LEN
 
 uint32_t hdPath[HDPATH_LEN_DEFAULT];
 
-uint8_t bech32_hrp_len;
-char bech32_hrp[MAX_BECH32_HRP_LEN + 1];
+// HRPs of the selected network, with their checksum state already computed
+typedef struct {
+    uint32_t coinType;
+    bech32_prefix_t address;
+    bech32_prefix_t pubkey;
+    bech32_prefix_t paymentAddr;
+    bech32_prefix_t extFullViewingKey;
+} network_context_t;
+
+static network_context_t network;
+
+zxerr_t crypto_setNetwork(uint32_t coinType) {
+    if (network.address.hrp != NULL && network.coinType == coinType) {
+        return zxerr_ok;
+    }
+
+    network.address.hrp = NULL;
+    const bool testnet = coinType == HDPATH_1_TESTNET;
+    CHECK_ZXERR(bech32PrefixInit(&network.pubkey, testnet ? TESTNET_PUBKEY_T_HRP : MAINNET_PUBKEY_T_HRP))
+    CHECK_ZXERR(bech32PrefixInit(&network.paymentAddr, testnet ? TESTNET_PAYMENT_ADDR_HRP : MAINNET_PAYMENT_ADDR_HRP))
+    CHECK_ZXERR(bech32PrefixInit(&network.extFullViewingKey,
+                                 testnet ? TESTNET_EXT_FULL_VIEWING_KEY_HRP : MAINNET_EXT_FULL_VIEWING_KEY_HRP))
+    // Set last, it marks the context as resolved
+    CHECK_ZXERR(bech32PrefixInit(&network.address, testnet ? TESTNET_ADDRESS_T_HRP : MAINNET_ADDRESS_T_HRP))
+    network.coinType = coinType;
+    return zxerr_ok;
+}
+
+// Resolved by extractHDPath, this only catches a path written without it
+static const network_context_t *currentNetwork() {
+    if (network.address.hrp == NULL || network.coinType != hdPath[1]) {
+        if (crypto_setNetwork(hdPath[1]) != zxerr_ok) {
+            return NULL;
+        }
+    }
+    return &network;
+}
+
+zxerr_t crypto_encodePubkey(const uint8_t *pubkey, uint16_t pubkeyLen, char *output, uint16_t outputLen) {
+    const network_context_t *net = currentNetwork();
+    if (net == NULL) {
+        return zxerr_unknown;
+    }
+    return bech32EncodeWithPrefix(output, outputLen, &net->pubkey, pubkey, pubkeyLen, 1, BECH32_ENCODING_BECH32M);
+}
 
 static zxerr_t crypto_publicKeyHash_ed25519(uint8_t *publicKeyHash, const uint8_t *pubkey){
     if (publicKeyHash == NULL || pubkey == NULL) {
@@ -67,14 +104,7 @@ static zxerr_t crypto_publicKeyHash_ed25519(uint8_t *publicKeyHash, const uint8_
 
     // Step 2. Hash the serialized public key with sha256.
     uint8_t pkh[CX_SHA256_SIZE] = {0};
-#if defined(TARGET_NANOS) || defined(TARGET_NANOS2) || defined(TARGET_NANOX) || defined(TARGET_STAX)
-    cx_hash_sha256((const uint8_t*) borshEncodedPubKey, PK_LEN_25519 + 1, pkh, CX_SHA256_SIZE);
-#else
-    picohash_ctx_t ctx;
-    picohash_init_sha256(&ctx);
-    picohash_update(&ctx, borshEncodedPubKey, PK_LEN_25519 + 1);
-    picohash_final(&ctx, pkh);
-#endif
+    CHECK_ZXERR(hash_sha256(borshEncodedPubKey, PK_LEN_25519 + 1, pkh))
     CHECK_APP_CANARY()
 
     // Step 3. Take the hex encoding of the hash (using upper-case);
@@ -97,14 +127,8 @@ zxerr_t crypto_encodeRawPubkey(const uint8_t* rawPubkey, uint16_t rawPubkeyLen,
     MEMZERO(output, outputLen);
     // Response [len(1) | pubkey(?)]
 
-    char HRP[15] = MAINNET_PUBKEY_T_HRP;
-    if (hdPath[1] == HDPATH_1_TESTNET) {
-        strcpy(HRP, TESTNET_PUBKEY_T_HRP);
-    }
-
     char pubkey[100] = {0};
-    CHECK_ZXERR(bech32EncodeFromBytes(pubkey, sizeof(pubkey), HRP,
-                                      rawPubkey, PK_LEN_25519_PLUS_TAG, 1, BECH32_ENCODING_BECH32M));
+    CHECK_ZXERR(crypto_encodePubkey(rawPubkey, PK_LEN_25519_PLUS_TAG, pubkey, sizeof(pubkey)))
 
     const uint16_t pubkeyLen = strnlen(pubkey, sizeof(pubkey));
     if (pubkeyLen > 255 || pubkeyLen >= outputLen) {
@@ -124,15 +148,15 @@ zxerr_t crypto_encodeAddress(const uint8_t *pubkey, uint16_t pubkeyLen, uint8_t
     uint8_t publicKeyHash[21] = {0};
     CHECK_ZXERR(crypto_publicKeyHash_ed25519(publicKeyHash, pubkey));
 
-    char HRP[10] = MAINNET_ADDRESS_T_HRP;
-    if (hdPath[1] == HDPATH_1_TESTNET) {
-        strcpy(HRP, TESTNET_ADDRESS_T_HRP);
+    const network_context_t *net = currentNetwork();
+    if (net == NULL) {
+        return zxerr_unknown;
     }
 
     // Step 2. Encode the public key hash with bech32m
     char address[100] = {0};
-    CHECK_ZXERR(bech32EncodeFromBytes(address, sizeof(address), HRP,
-                                      publicKeyHash, sizeof(publicKeyHash), 1, BECH32_ENCODING_BECH32M));
+    CHECK_ZXERR(bech32EncodeWithPrefix(address, sizeof(address), &net->address,
+                                       publicKeyHash, sizeof(publicKeyHash), 1, BECH32_ENCODING_BECH32M))
 
     const uint16_t addressLen = strnlen(address, sizeof(address));
     if (addressLen > 255 || addressLen >= outputLen) {
@@ -148,104 +172,111 @@ parser_error_t crypto_encodeLargeBech32(const uint8_t *address, size_t addressLe
         return parser_unexpected_value;
     }
 
-    char HRP[12] = MAINNET_PAYMENT_ADDR_HRP;
-    if (!paymentAddr) {
-        strcpy(HRP, MAINNET_EXT_FULL_VIEWING_KEY_HRP);
-    }
-
-#if defined(LEDGER_SPECIFIC)
-    if (hdPath[1] == HDPATH_1_TESTNET) {
-        strcpy(HRP, TESTNET_PAYMENT_ADDR_HRP);
-        if (!paymentAddr) {
-            strcpy(HRP, TESTNET_EXT_FULL_VIEWING_KEY_HRP);
-        }
+    const network_context_t *net = currentNetwork();
+    if (net == NULL) {
+        return parser_unexpected_value;
     }
-#endif
+    const bech32_prefix_t *prefix = paymentAddr ? &net->paymentAddr : &net->extFullViewingKey;
 
-    if(bech32EncodeFromLargeBytes((char *)output, outputLen, HRP, (uint8_t*) address, addressLen, 1, BECH32_ENCODING_BECH32M) != zxerr_ok) {
+    if(bech32EncodeWithPrefix((char *)output, outputLen, prefix, address, addressLen, 1, BECH32_ENCODING_BECH32M) != zxerr_ok) {
         return parser_unexpected_value;
     };
     return parser_ok;
 }
 
+#define ADDRESS_PAYLOAD_LEN (ADDRESS_LEN_BYTES - 1)
+
+// Internal addresses indexed by their tag. Addresses without payload are always the
+// prefix followed by zeros, so their bech32m strings are stored for both networks
+typedef struct {
+    uint8_t prefix;
+    uint8_t payloadLen;
+    // Offset of the payload bytes_t in InternalAddress
+    uint8_t payloadOffset;
+    const char *mainnet;
+    const char *testnet;
+} internal_address_info_t;
+
+static const internal_address_info_t internalAddresses[] = {
+    {PREFIX_POS, 0, 0,
+     "tnam1qgqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqc8j2fp", "testtnam1qgqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq5c6j58"},
+    {PREFIX_SLASH_POOL, 0, 0,
+     "tnam1qvqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqayu05y", "testtnam1qvqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq3m5hfz"},
+    {PREFIX_PARAMETERS, 0, 0,
+     "tnam1qsqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqxdl54l", "testtnam1qsqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq2jhvge"},
+    {PREFIX_IBC, 0, 0,
+     "tnam1qcqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqvtr7x4", "testtnam1qcqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq5txmn"},
+    {PREFIX_IBC_TOKEN, ADDRESS_PAYLOAD_LEN, offsetof(InternalAddress, IbcToken.ibcTokenHash), NULL, NULL},
+    {PREFIX_GOVERNANCE, 0, 0,
+     "tnam1q5qqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqrw33g6", "testtnam1q5qqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq03ef4u"},
+    {PREFIX_ETH_BRIDGE, 0, 0,
+     "tnam1quqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqfgdmms", "testtnam1quqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq9h9rxk"},
+    {PREFIX_BRIDGE_POOL, 0, 0,
+     "tnam1pqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqu35hpf", "testtnam1pqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqswu0u0"},
+    {PREFIX_ERC20, ADDRESS_PAYLOAD_LEN, offsetof(InternalAddress, Erc20.erc20Addr), NULL, NULL},
+    {PREFIX_NUT, ADDRESS_PAYLOAD_LEN, offsetof(InternalAddress, Nut.ethAddr), NULL, NULL},
+    {PREFIX_MULTITOKEN, 0, 0,
+     "tnam1pyqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqej6juv", "testtnam1pyqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq4dj2p2"},
+    {PREFIX_PGF, 0, 0,
+     "tnam1pgqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqkhgajr", "testtnam1pgqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq6gq909"},
+    {PREFIX_MASP, 0, 0,
+     "tnam1pcqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqzmefah", "testtnam1pcqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqwy33q3"},
+    {PREFIX_TMP_STORAGE, 0, 0,
+     "tnam1puqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq8chvqj", "testtnam1puqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqt8l5a5"},
+};
+
 parser_error_t crypto_encodeAltAddress(const AddressAlt *addr, char *address, uint16_t addressLen) {
+    if (addr == NULL || address == NULL) {
+        return parser_unexpected_value;
+    }
+    MEMZERO(address, addressLen);
+
+    const network_context_t *net = currentNetwork();
+    if (net == NULL) {
+        return parser_unexpected_error;
+    }
+
     uint8_t tmpBuffer[ADDRESS_LEN_BYTES] = {0};
+    const bytes_t *payload = NULL;
 
     switch (addr->tag) {
         case 0:
             tmpBuffer[0] = PREFIX_ESTABLISHED;
-            MEMCPY(tmpBuffer + 1, addr->Established.hash.ptr, 20);
+            payload = &addr->Established.hash;
             break;
         case 1:
             tmpBuffer[0] = PREFIX_IMPLICIT;
-            MEMCPY(tmpBuffer + 1, addr->Implicit.pubKeyHash.ptr, 20);
+            payload = &addr->Implicit.pubKeyHash;
             break;
-        case 2:
-            switch (addr->Internal.tag) {
-            case 0:
-              tmpBuffer[0] = PREFIX_POS;
-              break;
-            case 1:
-              tmpBuffer[0] = PREFIX_SLASH_POOL;
-              break;
-            case 2:
-              tmpBuffer[0] = PREFIX_PARAMETERS;
-              break;
-            case 3:
-              tmpBuffer[0] = PREFIX_IBC;
-              break;
-            case 4:
-              tmpBuffer[0] = PREFIX_IBC_TOKEN;
-              MEMCPY(tmpBuffer + 1, addr->Internal.IbcToken.ibcTokenHash.ptr, 20);
-              break;
-            case 5:
-              tmpBuffer[0] = PREFIX_GOVERNANCE;
-              break;
-            case 6:
-              tmpBuffer[0] = PREFIX_ETH_BRIDGE;
-              break;
-            case 7:
-              tmpBuffer[0] = PREFIX_BRIDGE_POOL;
-              break;
-            case 8:
-              tmpBuffer[0] = PREFIX_ERC20;
-              MEMCPY(tmpBuffer + 1, addr->Internal.Erc20.erc20Addr.ptr, 20);
-              break;
-            case 9:
-              tmpBuffer[0] = PREFIX_NUT;
-              MEMCPY(tmpBuffer + 1, addr->Internal.Nut.ethAddr.ptr, 20);
-              break;
-            case 10:
-              tmpBuffer[0] = PREFIX_MULTITOKEN;
-              break;
-            case 11:
-              tmpBuffer[0] = PREFIX_PGF;
-              break;
-            case 12:
-              tmpBuffer[0] = PREFIX_MASP;
-              break;
-            case 13:
-              tmpBuffer[0] = PREFIX_TMP_STORAGE;
-              break;
+        case 2: {
+            if (addr->Internal.tag >= sizeof(internalAddresses) / sizeof(internalAddresses[0])) {
+                return parser_value_out_of_range;
+            }
+            const internal_address_info_t *info = &internalAddresses[addr->Internal.tag];
+            if (info->payloadLen == 0) {
+                const char *fixed = (const char *) PIC(net->coinType == HDPATH_1_TESTNET ? info->testnet : info->mainnet);
+                const size_t fixedLen = strlen(fixed);
+                if (fixedLen >= addressLen) {
+                    return parser_unexpected_error;
+                }
+                MEMCPY(address, fixed, fixedLen);
+                return parser_ok;
             }
+            tmpBuffer[0] = info->prefix;
+            payload = (const bytes_t *)((const uint8_t *)&addr->Internal + info->payloadOffset);
             break;
+        }
 
         default:
             return parser_value_out_of_range;
     }
 
-    char HRP[12] = MAINNET_ADDRESS_T_HRP;
-    // Check HRP for mainnet/testnet
-#if defined(LEDGER_SPECIFIC)
-    if (hdPath[1] == HDPATH_1_TESTNET) {
-        strcpy(HRP, TESTNET_ADDRESS_T_HRP);
-    }
-#endif
+    MEMCPY(tmpBuffer + 1, payload->ptr, ADDRESS_PAYLOAD_LEN);
 
-    const zxerr_t err = bech32EncodeFromBytes(address,
+    const zxerr_t err = bech32EncodeWithPrefix(address,
                                 addressLen,
-                                HRP,
-                                (uint8_t*) tmpBuffer,
+                                &net->address,
+                                tmpBuffer,
                                 ADDRESS_LEN_BYTES,
                                 1,
                                 BECH32_ENCODING_BECH32M);
@@ -263,15 +294,7 @@ zxerr_t crypto_sha256(const uint8_t *input, uint16_t inputLen, uint8_t *output,
 
     MEMZERO(output, outputLen);
 
-#if defined(TARGET_NANOS) || defined(TARGET_NANOS2) || defined(TARGET_NANOX) || defined(TARGET_STAX)
-    cx_hash_sha256(input, inputLen, output, CX_SHA256_SIZE);
-#else
-    picohash_ctx_t ctx;
-    picohash_init_sha256(&ctx);
-    picohash_update(&ctx, input, inputLen);
-    picohash_final(&ctx, output);
-#endif
-    return zxerr_ok;
+    return hash_sha256(input, inputLen, output);
 }
 
 zxerr_t crypto_computeCodeHash(section_t *extraData) {
@@ -280,17 +303,7 @@ zxerr_t crypto_computeCodeHash(section_t *extraData) {
     }
 
     if (extraData->commitmentDiscriminant) {
-#if defined(TARGET_NANOS) || defined(TARGET_NANOS2) || defined(TARGET_NANOX) || defined(TARGET_STAX)
-        cx_sha256_t sha256 = {0};
-        cx_sha256_init(&sha256);
-        CHECK_CX_OK(cx_sha256_update(&sha256, extraData->bytes.ptr, extraData->bytes.len));
-        CHECK_CX_OK(cx_sha256_final(&sha256, extraData->bytes_hash));
-#else
-        picohash_ctx_t sha256 = {0};
-        picohash_init_sha256(&sha256);
-        picohash_update(&sha256, extraData->bytes.ptr, extraData->bytes.len);
-        picohash_final(&sha256, extraData->bytes_hash);
-#endif
+        CHECK_ZXERR(hash_sha256(extraData->bytes.ptr, extraData->bytes.len, extraData->bytes_hash))
     }
     return zxerr_ok;
 }
@@ -301,29 +314,16 @@ zxerr_t crypto_hashExtraDataSection(const section_t *extraData, uint8_t *output,
     }
 
     const uint32_t extraDataTagLen = extraData->tag.len;
-#if defined(TARGET_NANOS) || defined(TARGET_NANOS2) || defined(TARGET_NANOX) || defined(TARGET_STAX)
-    cx_sha256_t sha256 = {0};
-    cx_sha256_init(&sha256);
-    CHECK_CX_OK(cx_sha256_update(&sha256, &extraData->discriminant, 1));
-    CHECK_CX_OK(cx_sha256_update(&sha256, extraData->salt.ptr, extraData->salt.len));
-    CHECK_CX_OK(cx_sha256_update(&sha256, extraData->bytes_hash, sizeof(extraData->bytes_hash)));
+    hash_sha256_t sha256;
+    CHECK_ZXERR(hash_sha256_init(&sha256))
+    CHECK_ZXERR(hash_sha256_update(&sha256, &extraData->discriminant, 1))
+    CHECK_ZXERR(hash_sha256_update(&sha256, extraData->salt.ptr, extraData->salt.len))
+    CHECK_ZXERR(hash_sha256_update(&sha256, extraData->bytes_hash, sizeof(extraData->bytes_hash)))
     uint8_t has_tag = (extraData->tag.ptr == NULL) ? 0 : 1;
-    CHECK_CX_OK(cx_sha256_update(&sha256, &has_tag, 1));
-    CHECK_CX_OK(cx_sha256_update(&sha256, (uint8_t*) &extraDataTagLen, has_tag*sizeof(extraDataTagLen)));
-    CHECK_CX_OK(cx_sha256_update(&sha256, extraData->tag.ptr, has_tag*extraDataTagLen));
-    CHECK_CX_OK(cx_sha256_final(&sha256, output));
-#else
-    picohash_ctx_t sha256 = {0};
-    picohash_init_sha256(&sha256);
-    picohash_update(&sha256, &extraData->discriminant, 1);
-    picohash_update(&sha256, extraData->salt.ptr, extraData->salt.len);
-    picohash_update(&sha256, extraData->bytes_hash, sizeof(extraData->bytes_hash));
-    uint8_t has_tag = (extraData->tag.ptr == NULL) ? 0 : 1;
-    picohash_update(&sha256, &has_tag, 1);
-    picohash_update(&sha256, (uint8_t*) &extraDataTagLen, has_tag*sizeof(extraDataTagLen));
-    picohash_update(&sha256, extraData->tag.ptr, has_tag*extraDataTagLen);
-    picohash_final(&sha256, output);
-#endif
+    CHECK_ZXERR(hash_sha256_update(&sha256, &has_tag, 1))
+    CHECK_ZXERR(hash_sha256_update(&sha256, (uint8_t*) &extraDataTagLen, has_tag*sizeof(extraDataTagLen)))
+    CHECK_ZXERR(hash_sha256_update(&sha256, extraData->tag.ptr, has_tag*extraDataTagLen))
+    CHECK_ZXERR(hash_sha256_final(&sha256, output))
 
     return zxerr_ok;
 }
@@ -333,24 +333,19 @@ zxerr_t crypto_hashDataSection(const section_t *data, uint8_t *output, uint32_t
         return zxerr_no_data;
     }
 
+    if (data->compacted) {
+        MEMCPY(output, data->bytes_hash, CX_SHA256_SIZE);
+        return zxerr_ok;
+    }
+
     const uint32_t dataBytesLen = data->bytes.len;
-#if defined(TARGET_NANOS) || defined(TARGET_NANOS2) || defined(TARGET_NANOX) || defined(TARGET_STAX)
-    cx_sha256_t sha256 = {0};
-    cx_sha256_init(&sha256);
-    CHECK_CX_OK(cx_sha256_update(&sha256, &data->discriminant, 1));
-    CHECK_CX_OK(cx_sha256_update(&sha256, data->salt.ptr, data->salt.len));
-    CHECK_CX_OK(cx_sha256_update(&sha256, (uint8_t*) &dataBytesLen, sizeof(dataBytesLen)));
-    CHECK_CX_OK(cx_sha256_update(&sha256, data->bytes.ptr, dataBytesLen));
-    CHECK_CX_OK(cx_sha256_final(&sha256, output));
-#else
-    picohash_ctx_t sha256 = {0};
-    picohash_init_sha256(&sha256);
-    picohash_update(&sha256, &data->discriminant, 1);
-    picohash_update(&sha256, data->salt.ptr, data->salt.len);
-    picohash_update(&sha256, (uint8_t*) &dataBytesLen, sizeof(dataBytesLen));
-    picohash_update(&sha256, data->bytes.ptr, dataBytesLen);
-    picohash_final(&sha256, output);
-#endif
+    hash_sha256_t sha256;
+    CHECK_ZXERR(hash_sha256_init(&sha256))
+    CHECK_ZXERR(hash_sha256_update(&sha256, &data->discriminant, 1))
+    CHECK_ZXERR(hash_sha256_update(&sha256, data->salt.ptr, data->salt.len))
+    CHECK_ZXERR(hash_sha256_update(&sha256, (uint8_t*) &dataBytesLen, sizeof(dataBytesLen)))
+    CHECK_ZXERR(hash_sha256_update(&sha256, data->bytes.ptr, dataBytesLen))
+    CHECK_ZXERR(hash_sha256_final(&sha256, output))
 
     return zxerr_ok;
 }
@@ -361,29 +356,16 @@ zxerr_t crypto_hashCodeSection(const section_t *code, uint8_t *output, uint32_t
     }
 
     const uint32_t codeTagLen = code->tag.len;
-#if defined(TARGET_NANOS) || defined(TARGET_NANOS2) || defined(TARGET_NANOX) || defined(TARGET_STAX)
-    cx_sha256_t sha256 = {0};
-    cx_sha256_init(&sha256);
-    CHECK_CX_OK(cx_sha256_update(&sha256, &code->discriminant, 1));
-    CHECK_CX_OK(cx_sha256_update(&sha256, code->salt.ptr, code->salt.len));
-    CHECK_CX_OK(cx_sha256_update(&sha256, code->bytes_hash, sizeof(code->bytes_hash)));
-    uint8_t has_tag = (code->tag.ptr == NULL) ? 0 : 1;
-    CHECK_CX_OK(cx_sha256_update(&sha256, &has_tag, 1));
-    CHECK_CX_OK(cx_sha256_update(&sha256, (uint8_t*) &codeTagLen, has_tag*sizeof(codeTagLen)));
-    CHECK_CX_OK(cx_sha256_update(&sha256, code->tag.ptr, has_tag*codeTagLen));
-    CHECK_CX_OK(cx_sha256_final(&sha256, output));
-#else
-    picohash_ctx_t sha256 = {0};
-    picohash_init_sha256(&sha256);
-    picohash_update(&sha256, &code->discriminant, 1);
-    picohash_update(&sha256, code->salt.ptr, code->salt.len);
-    picohash_update(&sha256, code->bytes_hash, sizeof(code->bytes_hash));
+    hash_sha256_t sha256;
+    CHECK_ZXERR(hash_sha256_init(&sha256))
+    CHECK_ZXERR(hash_sha256_update(&sha256, &code->discriminant, 1))
+    CHECK_ZXERR(hash_sha256_update(&sha256, code->salt.ptr, code->salt.len))
+    CHECK_ZXERR(hash_sha256_update(&sha256, code->bytes_hash, sizeof(code->bytes_hash)))
     uint8_t has_tag = (code->tag.ptr == NULL) ? 0 : 1;
-    picohash_update(&sha256, &has_tag, 1);
-    picohash_update(&sha256, (uint8_t*) &codeTagLen, has_tag*sizeof(codeTagLen));
-    picohash_update(&sha256, code->tag.ptr, has_tag*codeTagLen);
-    picohash_final(&sha256, output);
-#endif
+    CHECK_ZXERR(hash_sha256_update(&sha256, &has_tag, 1))
+    CHECK_ZXERR(hash_sha256_update(&sha256, (uint8_t*) &codeTagLen, has_tag*sizeof(codeTagLen)))
+    CHECK_ZXERR(hash_sha256_update(&sha256, code->tag.ptr, has_tag*codeTagLen))
+    CHECK_ZXERR(hash_sha256_final(&sha256, output))
 
     return zxerr_ok;
 }
@@ -417,21 +399,12 @@ zxerr_t crypto_serializeData(const uint64_t dataSize, uint8_t *buffer, uint16_t
 parser_error_t convertKey(const uint8_t spendingKey[KEY_LENGTH], const uint8_t modifier, uint8_t outputKey[KEY_LENGTH],
                           bool reduceWideByte) {
     uint8_t output[64] = {0};
-#if defined(LEDGER_SPECIFIC)
-    cx_blake2b_t ctx = {0};
-    ASSERT_CX_OK(cx_blake2b_init2_no_throw(&ctx, BLAKE2B_OUTPUT_LEN, NULL, 0, (uint8_t *)EXPANDED_SPEND_BLAKE2_KEY,
-                                           sizeof(EXPANDED_SPEND_BLAKE2_KEY)));
-    ASSERT_CX_OK(cx_blake2b_update(&ctx, spendingKey, KEY_LENGTH));
-    ASSERT_CX_OK(cx_blake2b_update(&ctx, &modifier, 1));
-    cx_blake2b_final(&ctx, output);
-#else
-    blake2b_state state = {0};
-    blake2b_init_with_personalization(&state, BLAKE2B_OUTPUT_LEN, (const uint8_t *)EXPANDED_SPEND_BLAKE2_KEY,
-                                      sizeof(EXPANDED_SPEND_BLAKE2_KEY));
-    blake2b_update(&state, spendingKey, KEY_LENGTH);
-    blake2b_update(&state, &modifier, 1);
-    blake2b_final(&state, output, sizeof(output));
-#endif
+    hash_blake2b_t ctx;
+    ASSERT_HASH_OK(hash_blake2b_init(&ctx, sizeof(output), (const uint8_t *)EXPANDED_SPEND_BLAKE2_KEY,
+                                     sizeof(EXPANDED_SPEND_BLAKE2_KEY)));
+    ASSERT_HASH_OK(hash_blake2b_update(&ctx, spendingKey, KEY_LENGTH));
+    ASSERT_HASH_OK(hash_blake2b_update(&ctx, &modifier, 1));
+    ASSERT_HASH_OK(hash_blake2b_final(&ctx, output));
 
      if (reduceWideByte) {
          from_bytes_wide(output, outputKey);
@@ -453,6 +426,15 @@ parser_error_t generate_key(const uint8_t expandedKey[KEY_LENGTH], constant_key_
     return parser_ok;
 }
 
+// ak = [ask] SpendingKeyGenerator and nk = [nsk] ProofGenerationKeyGenerator,
+// computed together so both points share a single affine conversion
+parser_error_t computeAkNk(const ask_t ask, const nsk_t nsk, ak_t ak, nk_t nk) {
+    if (ask == NULL || nsk == NULL || ak == NULL || nk == NULL) {
+        return parser_no_data;
+    }
+    return compute_ak_nk(ask, nsk, ak, nk);
+}
+
 parser_error_t computeIVK(const ak_t ak, const nk_t nk, ivk_t ivk) {
     blake2s_state state = {0};
     blake2s_init_with_personalization(&state, 32, (const uint8_t *)CRH_IVK_PERSONALIZATION, sizeof(CRH_IVK_PERSONALIZATION));
@@ -469,37 +451,21 @@ parser_error_t computeMasterFromSeed(const uint8_t seed[KEY_LENGTH],  uint8_t ma
     if(seed == NULL || master_sk == NULL) {
         return parser_unexpected_error;
     }
-#if defined(LEDGER_SPECIFIC)
-    cx_blake2b_t ctx = {0};
-    ASSERT_CX_OK(cx_blake2b_init2_no_throw(&ctx, BLAKE2B_OUTPUT_LEN, NULL, 0, (uint8_t *)SAPLING_MASTER_PERSONALIZATION,
-                                           sizeof(SAPLING_MASTER_PERSONALIZATION)));
-    ASSERT_CX_OK(cx_blake2b_update(&ctx, seed, KEY_LENGTH));
-    cx_blake2b_final(&ctx, master_sk);
-#else
-    blake2b_state state = {0};
-    blake2b_init_with_personalization(&state, BLAKE2B_OUTPUT_LEN, (const uint8_t *)SAPLING_MASTER_PERSONALIZATION,
-                                      sizeof(SAPLING_MASTER_PERSONALIZATION));
-    blake2b_update(&state, seed, KEY_LENGTH);
-    blake2b_final(&state, master_sk, EXTENDED_KEY_LENGTH);
-#endif
+    hash_blake2b_t ctx;
+    ASSERT_HASH_OK(hash_blake2b_init(&ctx, EXTENDED_KEY_LENGTH, (const uint8_t *)SAPLING_MASTER_PERSONALIZATION,
+                                     sizeof(SAPLING_MASTER_PERSONALIZATION)));
+    ASSERT_HASH_OK(hash_blake2b_update(&ctx, seed, KEY_LENGTH));
+    ASSERT_HASH_OK(hash_blake2b_final(&ctx, master_sk));
 
     return parser_ok;
 }
 
-bool check_diversifier(const uint8_t d[DIVERSIFIER_LENGTH]) {
-    if(d == NULL) {
-        return parser_unexpected_error;
-    }
-
-    uint8_t hash[32] = {0};
-
+// Hashing GH_FIRST_BLOCK always yields the same state, so start from its precomputed midstate
+void computeDiversifierHash(const uint8_t d[DIVERSIFIER_LENGTH], uint8_t hash[KEY_LENGTH]) {
     blake2s_state state = {0};
-    blake2s_init_with_personalization(&state, 32, (const uint8_t *)KEY_DIVERSIFICATION_PERSONALIZATION, sizeof(KEY_DIVERSIFICATION_PERSONALIZATION));
-    blake2s_update(&state, (const uint8_t *)GH_FIRST_BLOCK, sizeof(GH_FIRST_BLOCK));
+    blake2s_init_from_midstate(&state, KEY_LENGTH, KEY_DIVERSIFICATION_GH_MIDSTATE, sizeof(GH_FIRST_BLOCK));
     blake2s_update(&state, d, DIVERSIFIER_LENGTH);
     blake2s_final(&state, hash, KEY_LENGTH);
-
-    return is_valid_diversifier(hash);
 }
 
 // Return list with 4 diversifiers, starting computing form start_index
@@ -508,7 +474,7 @@ parser_error_t computeDiversifiersList(const uint8_t dk[KEY_LENGTH], uint8_t sta
         return parser_unexpected_error;
     }
 
-   return get_default_diversifier_list(dk, start_index, diversifier_list);
+   return get_diversifier_list(dk, start_index, diversifier_list, DIVERSIFIER_LIST_LENGTH);
 }
 
 static bool reached_max_index(uint8_t diversifier_index[DIVERSIFIER_LENGTH]) {
@@ -520,27 +486,51 @@ static bool reached_max_index(uint8_t diversifier_index[DIVERSIFIER_LENGTH]) {
     return true;
 }
 // Return a valid diversifier from the diversifier list, if not found, compute a new list, strating from the incremented
-// start_index
-parser_error_t computeDiversifier(const uint8_t dk[KEY_LENGTH], uint8_t start_index[DIVERSIFIER_LENGTH], uint8_t diversifier[DIVERSIFIER_LENGTH]) {
+// start_index. g_d receives the diversifier group hash, ready to be passed to computePkdFromGd
+parser_error_t computeDiversifier(const uint8_t dk[KEY_LENGTH], uint8_t start_index[DIVERSIFIER_LENGTH], uint8_t diversifier[DIVERSIFIER_LENGTH], uint8_t g_d[GD_LENGTH]) {
+    return computeDiversifierWithIndex(dk, start_index, diversifier, g_d, NULL);
+}
+
+static void add_to_index(uint8_t index[DIVERSIFIER_LENGTH], uint8_t value) {
+    for (uint8_t k = 0; k < DIVERSIFIER_LENGTH && value > 0; k++) {
+        const uint16_t sum = (uint16_t)index[k] + value;
+        index[k] = (uint8_t)sum;
+        value = (uint8_t)(sum >> 8);
+    }
+}
+
+// Same search as computeDiversifier, also returning the index of the diversifier found
+parser_error_t computeDiversifierWithIndex(const uint8_t dk[KEY_LENGTH], uint8_t start_index[DIVERSIFIER_LENGTH], uint8_t diversifier[DIVERSIFIER_LENGTH],
+                                           uint8_t g_d[GD_LENGTH], uint8_t found_index[DIVERSIFIER_LENGTH]) {
+    if (g_d == NULL) {
+        return parser_unexpected_error;
+    }
     bool found = false;
     uint8_t diversifier_list[DIVERSIFIER_LIST_LENGTH] = {0};
 
     while (!found)
     {
+        uint8_t list_index[DIVERSIFIER_LENGTH] = {0};
+        memcpy(list_index, start_index, DIVERSIFIER_LENGTH);
         CHECK_ERROR(computeDiversifiersList(dk, start_index, diversifier_list));
         for (uint8_t i = 0; i < 4; i++)
         {
-            uint8_t d[DIVERSIFIER_LENGTH] = {0};
-            memcpy(d, diversifier_list + i*DIVERSIFIER_LENGTH, DIVERSIFIER_LENGTH);
-            if (check_diversifier(d) && !found)
+            const uint8_t *d = diversifier_list + i*DIVERSIFIER_LENGTH;
+            uint8_t hash[KEY_LENGTH] = {0};
+            computeDiversifierHash(d, hash);
+            if (prepare_diversifier(hash, g_d))
             {
                memcpy(diversifier, d, DIVERSIFIER_LENGTH);
+               if (found_index != NULL) {
+                   add_to_index(list_index, i);
+                   memcpy(found_index, list_index, DIVERSIFIER_LENGTH);
+               }
                found = true;
                break;
             }
         }
 
-        if (reached_max_index(start_index))
+        if (!found && reached_max_index(start_index))
         {
             return parser_diversifier_not_found;
         }
@@ -549,18 +539,29 @@ parser_error_t computeDiversifier(const uint8_t dk[KEY_LENGTH], uint8_t start_in
     return parser_ok;
 }
 
+parser_error_t computePkdFromGd(const uint8_t ivk[KEY_LENGTH], const uint8_t g_d[GD_LENGTH], uint8_t pk_d[KEY_LENGTH]) {
+    if(ivk == NULL || g_d == NULL || pk_d == NULL) {
+        return parser_unexpected_error;
+    }
+    return get_pkd_list(ivk, g_d, 1, pk_d);
+}
+
+// Several addresses under the same ivk: g_d_list holds count prepared group hashes
+// (GD_LENGTH each) and pk_d_list receives count keys (KEY_LENGTH each)
+parser_error_t computePkdList(const uint8_t ivk[KEY_LENGTH], const uint8_t *g_d_list, uint8_t count, uint8_t *pk_d_list) {
+    if(ivk == NULL || g_d_list == NULL || pk_d_list == NULL) {
+        return parser_unexpected_error;
+    }
+    return get_pkd_list(ivk, g_d_list, count, pk_d_list);
+}
+
 parser_error_t computePkd(const uint8_t ivk[KEY_LENGTH], const uint8_t diversifier[DIVERSIFIER_LENGTH], uint8_t pk_d[KEY_LENGTH]) {
     if(ivk == NULL || diversifier == NULL || pk_d == NULL) {
         return parser_unexpected_error;
     }
 
     uint8_t hash[32] = {0};
-
-    blake2s_state state = {0};
-    blake2s_init_with_personalization(&state, 32, (const uint8_t *)KEY_DIVERSIFICATION_PERSONALIZATION, sizeof(KEY_DIVERSIFICATION_PERSONALIZATION));
-    blake2s_update(&state, (const uint8_t *)GH_FIRST_BLOCK, sizeof(GH_FIRST_BLOCK));
-    blake2s_update(&state, diversifier, DIVERSIFIER_LENGTH);
-    blake2s_final(&state, hash, KEY_LENGTH);
+    computeDiversifierHash(diversifier, hash);
 
     zemu_log_stack("computePkd got hash");
     CHECK_ERROR(get_pkd(ivk, hash, pk_d));
@@ -568,48 +569,39 @@ parser_error_t computePkd(const uint8_t ivk[KEY_LENGTH], const uint8_t diversifi
     return parser_ok;
 }
 
-static void u64_to_bytes(uint64_t value, uint8_t array[32]) {
-    MEMZERO(array, 32);
-
-    // Fill the first 8 bytes with the uint64_t value in little-endian order
-    for (int i = 0; i < 8; i++) {
-        array[i] = (value >> (i * 8)) & 0xFF;
-    }
-}
-
 //https://github.com/anoma/masp/blob/main/masp_primitives/src/sapling.rs#L194
 parser_error_t computeValueCommitment(uint64_t value, uint8_t *rcv, uint8_t *identifier, uint8_t *cv) {
     if(rcv == NULL || identifier == NULL || cv == NULL) {
         return parser_unexpected_error;
     }
 
-    uint8_t value_bytes[32] = {0};
-    u64_to_bytes(value, value_bytes);
-
     uint8_t hash[32] = {0};
     blake2s_state state = {0};
     blake2s_init_with_personalization(&state, 32, (const uint8_t *)VALUE_COMMITMENT_GENERATOR_PERSONALIZATION, sizeof(VALUE_COMMITMENT_GENERATOR_PERSONALIZATION));
     blake2s_update(&state, identifier, KEY_LENGTH);
     blake2s_final(&state, hash, KEY_LENGTH);
 
-    uint8_t scalar[32] = {0};
-    CHECK_ERROR(scalar_multiplication(rcv, ValueCommitmentRandomnessGenerator, scalar));
-    CHECK_ERROR(add_points(hash, value_bytes, scalar, cv));
+    CHECK_ERROR(compute_value_commitment(hash, value, rcv, cv));
 
     return parser_ok;
 }
 
 
-parser_error_t computeRk(keys_t *keys, uint8_t *alpha, uint8_t *rk) {
-    if(keys == NULL || alpha == NULL || rk == NULL) {
+parser_error_t computeRk(const rs_scalar_t *ask, uint8_t *alpha, uint8_t *rk) {
+    if(ask == NULL || alpha == NULL || rk == NULL) {
         return parser_unexpected_error;
     }
-    uint8_t rsk[KEY_LENGTH] = {0};
+    rs_scalar_t rsk = {0};
+    uint8_t rsk_bytes[KEY_LENGTH] = {0};
     // get randomized secret
-    CHECK_ERROR(randomized_secret_from_seed(keys->ask, alpha, rsk));
+    parser_error_t err = randomized_secret(ask, alpha, &rsk, rsk_bytes);
 
     //rsk to rk
-    CHECK_ERROR(scalar_multiplication(rsk, SpendingKeyGenerator, rk));
+    if (err == parser_ok) {
+        err = scalar_multiplication(rsk_bytes, SpendingKeyGenerator, rk);
+    }
 
-    return parser_ok;
+    MEMZERO(&rsk, sizeof(rsk));
+    MEMZERO(rsk_bytes, sizeof(rsk_bytes));
+    return err;
 }
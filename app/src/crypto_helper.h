@@ -24,6 +24,7 @@ extern "C" {
 #include "zxerror.h"
 #include "parser_common.h"
 #include "keys_def.h"
+#include "rslib.h"
 
 #define CODE_HASH_SIZE  32
 #define TIMESTAMP_SIZE  14
@@ -36,10 +37,10 @@ extern "C" {
 #define MODIFIER_DK  0x10
 
 
-#define ASSERT_CX_OK(CALL)      \
+#define ASSERT_HASH_OK(CALL)      \
   do {                         \
-    cx_err_t __cx_err = CALL;  \
-    if (__cx_err != CX_OK) {   \
+    zxerr_t __hash_err = CALL;  \
+    if (__hash_err != zxerr_ok) {   \
       return parser_unexpected_error;    \
     }                          \
   } while (0)
@@ -47,6 +48,11 @@ extern "C" {
 zxerr_t crypto_encodeRawPubkey(const uint8_t* rawPubkey, uint16_t rawPubkeyLen, uint8_t *output, uint16_t outputLen);
 zxerr_t crypto_encodeAddress(const uint8_t *pubkey, uint16_t pubkeyLen, uint8_t *output, uint16_t outputLen);
 
+// Resolves the HRPs of the network given by the coin type of the derivation path
+zxerr_t crypto_setNetwork(uint32_t coinType);
+// Bech32m pubkey with the HRP of the selected network
+zxerr_t crypto_encodePubkey(const uint8_t *pubkey, uint16_t pubkeyLen, char *output, uint16_t outputLen);
+
 zxerr_t crypto_sha256(const uint8_t *input, uint16_t inputLen,
                       uint8_t *output, uint16_t outputLen);
 
@@ -59,13 +65,19 @@ zxerr_t crypto_hashExtraDataSection(const section_t *section, uint8_t *output, u
 // MASP SECTION
 parser_error_t convertKey(const uint8_t spendingKey[KEY_LENGTH], const uint8_t modifier, uint8_t outputKey[KEY_LENGTH], bool reduceWideByte);
 parser_error_t generate_key(const uint8_t expandedKey[KEY_LENGTH], constant_key_t keyType, uint8_t output[KEY_LENGTH]);
+parser_error_t computeAkNk(const ask_t ask, const nsk_t nsk, ak_t ak, nk_t nk);
 parser_error_t computeIVK(const ak_t ak, const nk_t nk, ivk_t ivk);
 parser_error_t computeMasterFromSeed(const uint8_t seed[KEY_LENGTH],  uint8_t master_sk[EXTENDED_KEY_LENGTH]);
 parser_error_t computeDiversifiersList(const uint8_t dk[KEY_LENGTH], uint8_t div_start_index[DIVERSIFIER_LENGTH], uint8_t diversifier_list[DIVERSIFIER_LIST_LENGTH]);
-parser_error_t computeDiversifier(const uint8_t dk[KEY_LENGTH], uint8_t start_index[DIVERSIFIER_LENGTH], uint8_t diversifier[DIVERSIFIER_LENGTH]);
+parser_error_t computeDiversifier(const uint8_t dk[KEY_LENGTH], uint8_t start_index[DIVERSIFIER_LENGTH], uint8_t diversifier[DIVERSIFIER_LENGTH], uint8_t g_d[GD_LENGTH]);
+parser_error_t computeDiversifierWithIndex(const uint8_t dk[KEY_LENGTH], uint8_t start_index[DIVERSIFIER_LENGTH], uint8_t diversifier[DIVERSIFIER_LENGTH],
+                                           uint8_t g_d[GD_LENGTH], uint8_t found_index[DIVERSIFIER_LENGTH]);
+void computeDiversifierHash(const uint8_t d[DIVERSIFIER_LENGTH], uint8_t hash[KEY_LENGTH]);
 parser_error_t computePkd(const uint8_t ivk[KEY_LENGTH], const uint8_t diversifier[DIVERSIFIER_LENGTH], uint8_t pk_d[KEY_LENGTH]);
+parser_error_t computePkdFromGd(const uint8_t ivk[KEY_LENGTH], const uint8_t g_d[GD_LENGTH], uint8_t pk_d[KEY_LENGTH]);
+parser_error_t computePkdList(const uint8_t ivk[KEY_LENGTH], const uint8_t *g_d_list, uint8_t count, uint8_t *pk_d_list);
 parser_error_t computeValueCommitment(uint64_t value, uint8_t *rcv, uint8_t *identifier, uint8_t *cv);
-parser_error_t computeRk(keys_t *keys, uint8_t *alpha, uint8_t *rk);
+parser_error_t computeRk(const rs_scalar_t *ask, uint8_t *alpha, uint8_t *rk);
 parser_error_t crypto_encodeLargeBech32( const uint8_t *address, size_t addressLen, uint8_t *output, size_t outputLen, bool paymentAddr);
 parser_error_t crypto_encodeAltAddress(const AddressAlt *addr, char *address, uint16_t addressLen);
 #ifdef __cplusplus
@@ -0,0 +1,169 @@
+/*******************************************************************************
+*   (c) 2018 - 2024 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "hashing.h"
+
+// Copy the data into the staging buffer if it fits
+static bool staging_append(hash_staging_t *staging, const uint8_t *data, size_t dataLen) {
+    if (dataLen > (size_t)(HASH_STAGING_LEN - staging->len)) {
+        return false;
+    }
+    MEMCPY(staging->buffer + staging->len, data, dataLen);
+    staging->len += (uint8_t)dataLen;
+    return true;
+}
+
+static zxerr_t blake2b_absorb(hash_blake2b_t *hash, const uint8_t *data, size_t dataLen) {
+    if (dataLen == 0) {
+        return zxerr_ok;
+    }
+#if defined(LEDGER_SPECIFIC)
+    CHECK_CX_OK(cx_hash_no_throw(&hash->ctx.header, 0, data, dataLen, NULL, 0));
+#else
+    if (blake2b_update(&hash->state, data, dataLen) < 0) {
+        return zxerr_unknown;
+    }
+#endif
+    return zxerr_ok;
+}
+
+static zxerr_t blake2b_flush(hash_blake2b_t *hash) {
+    CHECK_ZXERR(blake2b_absorb(hash, hash->staging.buffer, hash->staging.len));
+    hash->staging.len = 0;
+    return zxerr_ok;
+}
+
+static zxerr_t sha256_absorb(hash_sha256_t *hash, const uint8_t *data, size_t dataLen) {
+    if (dataLen == 0) {
+        return zxerr_ok;
+    }
+#if defined(LEDGER_SPECIFIC)
+    CHECK_CX_OK(cx_sha256_update(&hash->ctx, data, dataLen));
+#else
+    picohash_update(&hash->ctx, data, dataLen);
+#endif
+    return zxerr_ok;
+}
+
+static zxerr_t sha256_flush(hash_sha256_t *hash) {
+    CHECK_ZXERR(sha256_absorb(hash, hash->staging.buffer, hash->staging.len));
+    hash->staging.len = 0;
+    return zxerr_ok;
+}
+
+zxerr_t hash_blake2b_init(hash_blake2b_t *hash, size_t outLen, const uint8_t *personalization, size_t personalizationLen) {
+    if (hash == NULL || outLen == 0 || outLen > HASH_BLAKE2B_MAX_LEN) {
+        return zxerr_invalid_crypto_settings;
+    }
+
+    MEMZERO(hash, sizeof(*hash));
+    hash->outLen = outLen;
+#if defined(LEDGER_SPECIFIC)
+    // cx takes the output length in bits
+    CHECK_CX_OK(cx_blake2b_init2_no_throw(&hash->ctx, outLen * 8, NULL, 0, (uint8_t *)personalization, personalizationLen));
+#else
+    if (blake2b_init_with_personalization(&hash->state, outLen, personalization, personalizationLen) < 0) {
+        return zxerr_unknown;
+    }
+#endif
+    return zxerr_ok;
+}
+
+zxerr_t hash_blake2b_update(hash_blake2b_t *hash, const uint8_t *data, size_t dataLen) {
+    if (hash == NULL || (data == NULL && dataLen > 0)) {
+        return zxerr_no_data;
+    }
+    if (staging_append(&hash->staging, data, dataLen)) {
+        return zxerr_ok;
+    }
+
+    CHECK_ZXERR(blake2b_flush(hash));
+    if (staging_append(&hash->staging, data, dataLen)) {
+        return zxerr_ok;
+    }
+    return blake2b_absorb(hash, data, dataLen);
+}
+
+zxerr_t hash_blake2b_final(hash_blake2b_t *hash, uint8_t *output) {
+    if (hash == NULL || output == NULL) {
+        return zxerr_no_data;
+    }
+
+    // The staging buffer holds the last input bytes, which can be key material
+    const zxerr_t err = blake2b_flush(hash);
+    MEMZERO(&hash->staging, sizeof(hash->staging));
+    CHECK_ZXERR(err);
+#if defined(LEDGER_SPECIFIC)
+    CHECK_CX_OK(cx_hash_final(&hash->ctx.header, output));
+#else
+    if (blake2b_final(&hash->state, output, hash->outLen) < 0) {
+        return zxerr_unknown;
+    }
+#endif
+    return zxerr_ok;
+}
+
+zxerr_t hash_sha256_init(hash_sha256_t *hash) {
+    if (hash == NULL) {
+        return zxerr_no_data;
+    }
+
+    MEMZERO(hash, sizeof(*hash));
+#if defined(LEDGER_SPECIFIC)
+    cx_sha256_init(&hash->ctx);
+#else
+    picohash_init_sha256(&hash->ctx);
+#endif
+    return zxerr_ok;
+}
+
+zxerr_t hash_sha256_update(hash_sha256_t *hash, const uint8_t *data, size_t dataLen) {
+    if (hash == NULL || (data == NULL && dataLen > 0)) {
+        return zxerr_no_data;
+    }
+    if (staging_append(&hash->staging, data, dataLen)) {
+        return zxerr_ok;
+    }
+
+    CHECK_ZXERR(sha256_flush(hash));
+    if (staging_append(&hash->staging, data, dataLen)) {
+        return zxerr_ok;
+    }
+    return sha256_absorb(hash, data, dataLen);
+}
+
+zxerr_t hash_sha256_final(hash_sha256_t *hash, uint8_t output[HASH_SHA256_LEN]) {
+    if (hash == NULL || output == NULL) {
+        return zxerr_no_data;
+    }
+
+    // The staging buffer holds the last input bytes, which can be key material
+    const zxerr_t err = sha256_flush(hash);
+    MEMZERO(&hash->staging, sizeof(hash->staging));
+    CHECK_ZXERR(err);
+#if defined(LEDGER_SPECIFIC)
+    CHECK_CX_OK(cx_sha256_final(&hash->ctx, output));
+#else
+    picohash_final(&hash->ctx, output);
+#endif
+    return zxerr_ok;
+}
+
+zxerr_t hash_sha256(const uint8_t *data, size_t dataLen, uint8_t output[HASH_SHA256_LEN]) {
+    hash_sha256_t hash;
+    CHECK_ZXERR(hash_sha256_init(&hash));
+    CHECK_ZXERR(hash_sha256_update(&hash, data, dataLen));
+    return hash_sha256_final(&hash, output);
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************
+*   (c) 2018 - 2024 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "zxerror.h"
+#include "zxmacros.h"
+
+#if defined(LEDGER_SPECIFIC)
+#include "cx.h"
+#else
+#include "blake2.h"
+#include "picohash.h"
+#endif
+
+// Hashing used by the transaction and key code. The device backend goes through cx,
+// the host backend through the reference blake2b and picohash, so the same callers
+// build into the unit tests.
+//
+// Every cx update is a syscall, and most callers feed a few bytes at a time. Small
+// updates are staged and handed to the backend together once the staging buffer
+// would overflow, or on final. Digests do not change.
+
+#define HASH_SHA256_LEN 32
+#define HASH_BLAKE2B_MAX_LEN 64
+#define HASH_STAGING_LEN 64
+
+typedef struct {
+    uint8_t buffer[HASH_STAGING_LEN];
+    uint8_t len;
+} hash_staging_t;
+
+typedef struct {
+#if defined(LEDGER_SPECIFIC)
+    cx_blake2b_t ctx;
+#else
+    blake2b_state state;
+#endif
+    size_t outLen;
+    hash_staging_t staging;
+} hash_blake2b_t;
+
+typedef struct {
+#if defined(LEDGER_SPECIFIC)
+    cx_sha256_t ctx;
+#else
+    picohash_ctx_t ctx;
+#endif
+    hash_staging_t staging;
+} hash_sha256_t;
+
+// Independent blake2b streams that are fed side by side, such as the sub-digests
+// of the Sapling spends and outputs. On host, up to four lanes are compressed
+// together with AVX2 when the CPU supports it, one at a time otherwise. cx hashes
+// one stream at a time, so on device each lane is a plain context.
+#if defined(LEDGER_SPECIFIC)
+#define HASH_LANES 3
+#else
+#define HASH_LANES 4
+#define HASH_LANE_QUEUE_LEN 512
+#endif
+
+typedef struct {
+#if defined(LEDGER_SPECIFIC)
+    hash_blake2b_t lane[HASH_LANES];
+#else
+    // Word major, so one row holds the same state word of every lane
+    uint64_t h[8][HASH_LANES];
+    uint64_t t[HASH_LANES];
+    uint8_t buffer[HASH_LANES][HASH_LANE_QUEUE_LEN];
+    size_t bufferLen[HASH_LANES];
+#endif
+    uint8_t count;
+    size_t outLen;
+} hash_blake2b_lanes_t;
+
+// outLen is in bytes
+zxerr_t hash_blake2b_init(hash_blake2b_t *hash, size_t outLen, const uint8_t *personalization, size_t personalizationLen);
+zxerr_t hash_blake2b_update(hash_blake2b_t *hash, const uint8_t *data, size_t dataLen);
+zxerr_t hash_blake2b_final(hash_blake2b_t *hash, uint8_t *output);
+
+// Outputs are written back to back, count * outLen bytes
+zxerr_t hash_blake2b_lanes_init(hash_blake2b_lanes_t *lanes, uint8_t count, size_t outLen,
+                                const char *const personalizations[], size_t personalizationLen);
+zxerr_t hash_blake2b_lanes_update(hash_blake2b_lanes_t *lanes, uint8_t lane, const uint8_t *data, size_t dataLen);
+zxerr_t hash_blake2b_lanes_final(hash_blake2b_lanes_t *lanes, uint8_t *outputs);
+
+#if !defined(LEDGER_SPECIFIC)
+// Tests set it to run the scalar compression on hosts with AVX2
+extern bool hash_lanes_force_scalar;
+#endif
+
+zxerr_t hash_sha256_init(hash_sha256_t *hash);
+zxerr_t hash_sha256_update(hash_sha256_t *hash, const uint8_t *data, size_t dataLen);
+zxerr_t hash_sha256_final(hash_sha256_t *hash, uint8_t output[HASH_SHA256_LEN]);
+zxerr_t hash_sha256(const uint8_t *data, size_t dataLen, uint8_t output[HASH_SHA256_LEN]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,353 @@
+/*******************************************************************************
+*   (c) 2018 - 2024 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "hashing.h"
+#include <string.h>
+
+static zxerr_t lanes_check_init(const hash_blake2b_lanes_t *lanes, uint8_t count, size_t outLen,
+                                const char *const personalizations[], size_t personalizationLen) {
+    if (lanes == NULL || personalizations == NULL || count == 0 || count > HASH_LANES ||
+        outLen == 0 || outLen > HASH_BLAKE2B_MAX_LEN || personalizationLen > 16) {
+        return zxerr_invalid_crypto_settings;
+    }
+    return zxerr_ok;
+}
+
+#if defined(LEDGER_SPECIFIC)
+
+zxerr_t hash_blake2b_lanes_init(hash_blake2b_lanes_t *lanes, uint8_t count, size_t outLen,
+                                const char *const personalizations[], size_t personalizationLen) {
+    CHECK_ZXERR(lanes_check_init(lanes, count, outLen, personalizations, personalizationLen))
+
+    lanes->count = count;
+    lanes->outLen = outLen;
+    for (uint8_t i = 0; i < count; i++) {
+        CHECK_ZXERR(hash_blake2b_init(&lanes->lane[i], outLen, (const uint8_t *)personalizations[i], personalizationLen))
+    }
+    return zxerr_ok;
+}
+
+zxerr_t hash_blake2b_lanes_update(hash_blake2b_lanes_t *lanes, uint8_t lane, const uint8_t *data, size_t dataLen) {
+    if (lanes == NULL || lane >= lanes->count) {
+        return zxerr_no_data;
+    }
+    return hash_blake2b_update(&lanes->lane[lane], data, dataLen);
+}
+
+zxerr_t hash_blake2b_lanes_final(hash_blake2b_lanes_t *lanes, uint8_t *outputs) {
+    if (lanes == NULL || outputs == NULL) {
+        return zxerr_no_data;
+    }
+    for (uint8_t i = 0; i < lanes->count; i++) {
+        CHECK_ZXERR(hash_blake2b_final(&lanes->lane[i], outputs + i * lanes->outLen))
+    }
+    return zxerr_ok;
+}
+
+#else
+
+bool hash_lanes_force_scalar = false;
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define HASH_LANES_AVX2
+#include <immintrin.h>
+#endif
+
+#define BLAKE2B_BLOCK_LEN 128
+#define BLAKE2B_ROUNDS 12
+#define LANES_ALL(count) ((uint8_t)((1u << (count)) - 1))
+
+static const uint64_t blake2b_iv[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL,
+};
+
+static const uint8_t blake2b_sigma[BLAKE2B_ROUNDS][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+};
+
+static uint64_t load64(const uint8_t *src) {
+    uint64_t w = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+        w |= (uint64_t)src[i] << (8 * i);
+    }
+    return w;
+}
+
+static void store64(uint8_t *dst, uint64_t w) {
+    for (uint8_t i = 0; i < 8; i++) {
+        dst[i] = (uint8_t)(w >> (8 * i));
+    }
+}
+
+static uint64_t rotr64(uint64_t w, unsigned c) {
+    return (w >> c) | (w << (64 - c));
+}
+
+#define G_ROUNDS(G)                        \
+    G(r, 0, v[0], v[4], v[8], v[12]);     \
+    G(r, 1, v[1], v[5], v[9], v[13]);     \
+    G(r, 2, v[2], v[6], v[10], v[14]);    \
+    G(r, 3, v[3], v[7], v[11], v[15]);    \
+    G(r, 4, v[0], v[5], v[10], v[15]);    \
+    G(r, 5, v[1], v[6], v[11], v[12]);    \
+    G(r, 6, v[2], v[7], v[8], v[13]);     \
+    G(r, 7, v[3], v[4], v[9], v[14]);
+
+#define G_SCALAR(r, i, a, b, c, d)                          \
+    do {                                                    \
+        a = a + b + m[blake2b_sigma[r][2 * i]][lane];       \
+        d = rotr64(d ^ a, 32);                              \
+        c = c + d;                                          \
+        b = rotr64(b ^ c, 24);                              \
+        a = a + b + m[blake2b_sigma[r][2 * i + 1]][lane];   \
+        d = rotr64(d ^ a, 16);                              \
+        c = c + d;                                          \
+        b = rotr64(b ^ c, 63);                              \
+    } while (0)
+
+// m is word major like the state: m[word][lane]
+static void compress_scalar(uint64_t h[8][HASH_LANES], const uint64_t m[16][HASH_LANES],
+                            const uint64_t t[HASH_LANES], const uint64_t f[HASH_LANES], uint8_t mask) {
+    for (uint8_t lane = 0; lane < HASH_LANES; lane++) {
+        if ((mask & (1u << lane)) == 0) {
+            continue;
+        }
+
+        uint64_t v[16];
+        for (uint8_t i = 0; i < 8; i++) {
+            v[i] = h[i][lane];
+            v[i + 8] = blake2b_iv[i];
+        }
+        v[12] ^= t[lane];
+        v[14] ^= f[lane];
+
+        for (uint8_t r = 0; r < BLAKE2B_ROUNDS; r++) {
+            G_ROUNDS(G_SCALAR)
+        }
+
+        for (uint8_t i = 0; i < 8; i++) {
+            h[i][lane] ^= v[i] ^ v[i + 8];
+        }
+    }
+}
+
+#if defined(HASH_LANES_AVX2)
+
+#define ROTR32_AVX2(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define ROTR24_AVX2(x) _mm256_shuffle_epi8((x), rot24)
+#define ROTR16_AVX2(x) _mm256_shuffle_epi8((x), rot16)
+#define ROTR63_AVX2(x) _mm256_or_si256(_mm256_srli_epi64((x), 63), _mm256_add_epi64((x), (x)))
+
+#define G_AVX2(r, i, a, b, c, d)                                                                 \
+    do {                                                                                         \
+        a = _mm256_add_epi64(_mm256_add_epi64(a, b), mv[blake2b_sigma[r][2 * i]]);               \
+        d = ROTR32_AVX2(_mm256_xor_si256(d, a));                                                 \
+        c = _mm256_add_epi64(c, d);                                                              \
+        b = ROTR24_AVX2(_mm256_xor_si256(b, c));                                                 \
+        a = _mm256_add_epi64(_mm256_add_epi64(a, b), mv[blake2b_sigma[r][2 * i + 1]]);           \
+        d = ROTR16_AVX2(_mm256_xor_si256(d, a));                                                 \
+        c = _mm256_add_epi64(c, d);                                                              \
+        b = ROTR63_AVX2(_mm256_xor_si256(b, c));                                                 \
+    } while (0)
+
+// Each 256-bit register holds one state word of the four lanes. Every lane is
+// compressed, and only the ones in mask are written back.
+__attribute__((target("avx2")))
+static void compress_avx2(uint64_t h[8][HASH_LANES], const uint64_t m[16][HASH_LANES],
+                          const uint64_t t[HASH_LANES], const uint64_t f[HASH_LANES], uint8_t mask) {
+    const __m256i rot24 = _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+                                           3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+    const __m256i rot16 = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+                                           2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+    __m256i mv[16];
+    __m256i v[16];
+
+    for (uint8_t i = 0; i < 16; i++) {
+        mv[i] = _mm256_loadu_si256((const __m256i *)m[i]);
+    }
+    for (uint8_t i = 0; i < 8; i++) {
+        v[i] = _mm256_loadu_si256((const __m256i *)h[i]);
+        v[i + 8] = _mm256_set1_epi64x((long long)blake2b_iv[i]);
+    }
+    v[12] = _mm256_xor_si256(v[12], _mm256_loadu_si256((const __m256i *)t));
+    v[14] = _mm256_xor_si256(v[14], _mm256_loadu_si256((const __m256i *)f));
+
+    for (uint8_t r = 0; r < BLAKE2B_ROUNDS; r++) {
+        G_ROUNDS(G_AVX2)
+    }
+
+    for (uint8_t i = 0; i < 8; i++) {
+        uint64_t row[HASH_LANES];
+        const __m256i hi = _mm256_loadu_si256((const __m256i *)h[i]);
+        _mm256_storeu_si256((__m256i *)row, _mm256_xor_si256(hi, _mm256_xor_si256(v[i], v[i + 8])));
+        for (uint8_t lane = 0; lane < HASH_LANES; lane++) {
+            if (mask & (1u << lane)) {
+                h[i][lane] = row[lane];
+            }
+        }
+    }
+}
+
+static bool lanes_use_avx2(void) {
+    static int8_t supported = -1;
+    if (supported < 0) {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return supported == 1;
+}
+
+#endif
+
+// One compression for every lane in mask, reading each lane's block at offset.
+// The last block of a stream is zero padded and flagged as final.
+static void lanes_compress(hash_blake2b_lanes_t *lanes, const size_t offset[HASH_LANES], uint8_t mask, bool last) {
+    uint64_t m[16][HASH_LANES] = {0};
+    uint64_t f[HASH_LANES] = {0};
+
+    for (uint8_t lane = 0; lane < lanes->count; lane++) {
+        if ((mask & (1u << lane)) == 0) {
+            continue;
+        }
+
+        uint8_t block[BLAKE2B_BLOCK_LEN] = {0};
+        const size_t blockLen = last ? lanes->bufferLen[lane] - offset[lane] : BLAKE2B_BLOCK_LEN;
+        MEMCPY(block, lanes->buffer[lane] + offset[lane], blockLen);
+        for (uint8_t w = 0; w < 16; w++) {
+            m[w][lane] = load64(block + 8 * w);
+        }
+        lanes->t[lane] += blockLen;
+        if (last) {
+            f[lane] = UINT64_MAX;
+        }
+    }
+
+#if defined(HASH_LANES_AVX2)
+    if (!hash_lanes_force_scalar && lanes_use_avx2()) {
+        compress_avx2(lanes->h, m, lanes->t, f, mask);
+        return;
+    }
+#endif
+    compress_scalar(lanes->h, m, lanes->t, f, mask);
+}
+
+// Compress every queued block that cannot be the last one of its stream. Lanes
+// are masked off as they run out of blocks while the rest keep sharing compressions.
+static void lanes_drain(hash_blake2b_lanes_t *lanes) {
+    size_t offset[HASH_LANES] = {0};
+
+    while (true) {
+        uint8_t mask = 0;
+        for (uint8_t lane = 0; lane < lanes->count; lane++) {
+            if (lanes->bufferLen[lane] - offset[lane] > BLAKE2B_BLOCK_LEN) {
+                mask |= (uint8_t)(1u << lane);
+            }
+        }
+        if (mask == 0) {
+            break;
+        }
+
+        lanes_compress(lanes, offset, mask, false);
+        for (uint8_t lane = 0; lane < lanes->count; lane++) {
+            if (mask & (1u << lane)) {
+                offset[lane] += BLAKE2B_BLOCK_LEN;
+            }
+        }
+    }
+
+    for (uint8_t lane = 0; lane < lanes->count; lane++) {
+        if (offset[lane] > 0) {
+            lanes->bufferLen[lane] -= offset[lane];
+            memmove(lanes->buffer[lane], lanes->buffer[lane] + offset[lane], lanes->bufferLen[lane]);
+        }
+    }
+}
+
+zxerr_t hash_blake2b_lanes_init(hash_blake2b_lanes_t *lanes, uint8_t count, size_t outLen,
+                                const char *const personalizations[], size_t personalizationLen) {
+    CHECK_ZXERR(lanes_check_init(lanes, count, outLen, personalizations, personalizationLen))
+
+    MEMZERO(lanes, sizeof(*lanes));
+    lanes->count = count;
+    lanes->outLen = outLen;
+    for (uint8_t lane = 0; lane < count; lane++) {
+        if (personalizations[lane] == NULL) {
+            return zxerr_invalid_crypto_settings;
+        }
+        uint8_t personal[16] = {0};
+        MEMCPY(personal, personalizations[lane], personalizationLen);
+
+        for (uint8_t i = 0; i < 8; i++) {
+            lanes->h[i][lane] = blake2b_iv[i];
+        }
+        // Parameter block: digest length, no key, fanout 1, depth 1, personalization
+        lanes->h[0][lane] ^= 0x01010000ULL ^ (uint64_t)outLen;
+        lanes->h[6][lane] ^= load64(personal);
+        lanes->h[7][lane] ^= load64(personal + 8);
+    }
+    return zxerr_ok;
+}
+
+zxerr_t hash_blake2b_lanes_update(hash_blake2b_lanes_t *lanes, uint8_t lane, const uint8_t *data, size_t dataLen) {
+    if (lanes == NULL || lane >= lanes->count || (data == NULL && dataLen > 0)) {
+        return zxerr_no_data;
+    }
+
+    while (dataLen > 0) {
+        if (lanes->bufferLen[lane] == HASH_LANE_QUEUE_LEN) {
+            lanes_drain(lanes);
+        }
+        const size_t space = HASH_LANE_QUEUE_LEN - lanes->bufferLen[lane];
+        const size_t chunk = dataLen < space ? dataLen : space;
+        MEMCPY(lanes->buffer[lane] + lanes->bufferLen[lane], data, chunk);
+        lanes->bufferLen[lane] += chunk;
+        data += chunk;
+        dataLen -= chunk;
+    }
+    return zxerr_ok;
+}
+
+zxerr_t hash_blake2b_lanes_final(hash_blake2b_lanes_t *lanes, uint8_t *outputs) {
+    if (lanes == NULL || outputs == NULL) {
+        return zxerr_no_data;
+    }
+
+    lanes_drain(lanes);
+    const size_t offset[HASH_LANES] = {0};
+    lanes_compress(lanes, offset, LANES_ALL(lanes->count), true);
+
+    for (uint8_t lane = 0; lane < lanes->count; lane++) {
+        uint8_t digest[HASH_BLAKE2B_MAX_LEN] = {0};
+        for (uint8_t i = 0; i < 8; i++) {
+            store64(digest + 8 * i, lanes->h[i][lane]);
+        }
+        MEMCPY(outputs + lane * lanes->outLen, digest, lanes->outLen);
+    }
+    return zxerr_ok;
+}
+
+#endif
@@ -35,6 +35,8 @@ typedef enum {
 #define EXTENDED_KEY_LENGTH 64
 #define DIVERSIFIER_LENGTH 11
 #define DIVERSIFIER_LIST_LENGTH 44
+// Decompressed diversifier group hash (u || v)
+#define GD_LENGTH 64
 typedef uint8_t spending_key_t[KEY_LENGTH];
 typedef uint8_t ask_t[KEY_LENGTH];
 typedef uint8_t nsk_t[KEY_LENGTH];
@@ -46,6 +48,7 @@ typedef uint8_t dk_t[KEY_LENGTH];
 typedef uint8_t ivk_t[KEY_LENGTH];
 typedef uint8_t ovk_t[KEY_LENGTH];
 typedef uint8_t d_t[DIVERSIFIER_LENGTH];
+typedef uint8_t gd_t[GD_LENGTH];
 
 typedef uint8_t public_address_t[KEY_LENGTH];
 
@@ -34,6 +34,11 @@ const char EXPANDED_SPEND_BLAKE2_KEY[16] = "MASP__ExpandSeed";
 const char CRH_IVK_PERSONALIZATION[8] = "MASP_ivk";
 const char KEY_DIVERSIFICATION_PERSONALIZATION[8] = "MASP__gd";
 const char GH_FIRST_BLOCK[64] = "096b36a5804bfacef1691e173c366a47ff5ba84a44f26ddd7e8d9f79d5b42df0";
+// blake2s chaining value after initializing with KEY_DIVERSIFICATION_PERSONALIZATION and compressing GH_FIRST_BLOCK
+const uint32_t KEY_DIVERSIFICATION_GH_MIDSTATE[8] = {
+    0x4927e1af, 0xc7391e42, 0xd3f064ad, 0x48af0988,
+    0x1be9c81f, 0x3b73fa6c, 0x33306616, 0xb52ee806,
+};
 const char SINGNING_REGJUBJUB[16] = "MASP__RedJubjubH";
 const char VALUE_COMMITMENT_GENERATOR_PERSONALIZATION[8] = "MASP__v_";
 #ifdef __cplusplus
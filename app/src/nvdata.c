@@ -35,42 +35,76 @@ outputlist_t NV_CONST N_outputlist_impl __attribute__((aligned(64)));
 convertlist_t NV_CONST N_convertlist_impl __attribute__((aligned(64)));
 #define N_convertlist (*(NV_VOLATILE convertlist_t *)PIC(&N_convertlist_impl))
 
+diversifier_cache_t NV_CONST N_diversifier_cache_impl __attribute__((aligned(64)));
+#define N_diversifier_cache (*(NV_VOLATILE diversifier_cache_t *)PIC(&N_diversifier_cache_impl))
+
 transaction_header_t transaction_header;
 
+// Randomness for the first RAM_LIST_SIZE items of each list is kept in RAM,
+// so small shielded transactions never write it to flash. Larger lists spill
+// the remaining items to the NV lists above, at the same index.
+#if defined(TARGET_NANOS)
+#define RAM_LIST_SIZE 1
+#else
+#define RAM_LIST_SIZE 3
+#endif
+
+static spend_item_t ram_spendlist[RAM_LIST_SIZE];
+static output_item_t ram_outputlist[RAM_LIST_SIZE];
+static convert_item_t ram_convertlist[RAM_LIST_SIZE];
+
+// Set once the NV lists are known to hold no randomness from a previous transaction
+static bool nv_lists_clean = false;
+
 zxerr_t spend_append_rand_item(uint8_t *rcv, uint8_t *alpha) {
   if (transaction_header.spendlist_len >= SPEND_LIST_SIZE) {
     return zxerr_unknown;
   }
-  spend_item_t newitem;
-  MEMCPY(newitem.rcv, rcv, RANDOM_LEN);
-  MEMCPY(newitem.alpha, alpha, RANDOM_LEN);
+  const uint8_t i = transaction_header.spendlist_len;
+  if (i < RAM_LIST_SIZE) {
+    MEMCPY(ram_spendlist[i].rcv, rcv, RANDOM_LEN);
+    MEMCPY(ram_spendlist[i].alpha, alpha, RANDOM_LEN);
+  } else {
+    spend_item_t newitem;
+    MEMCPY(newitem.rcv, rcv, RANDOM_LEN);
+    MEMCPY(newitem.alpha, alpha, RANDOM_LEN);
 
-  MEMCPY_NV((void *)&N_spendlist.items[transaction_header.spendlist_len],
-            &newitem, sizeof(spend_item_t));
+    MEMCPY_NV((void *)&N_spendlist.items[i], &newitem, sizeof(spend_item_t));
+    MEMZERO(&newitem, sizeof(spend_item_t));
+    nv_lists_clean = false;
+  }
 
   transaction_header.spendlist_len += 1;
   return zxerr_ok;
 }
 
 spend_item_t *spendlist_retrieve_rand_item(uint8_t i) {
-  if (transaction_header.spendlist_len < i) {
+  if (transaction_header.spendlist_len <= i) {
     return NULL;
-  } else {
-    return (spend_item_t *)&N_spendlist.items[i];
   }
+  if (i < RAM_LIST_SIZE) {
+    return &ram_spendlist[i];
+  }
+  return (spend_item_t *)&N_spendlist.items[i];
 }
 
 zxerr_t output_append_rand_item(uint8_t *rcv, uint8_t *rcm) {
   if (transaction_header.outputlist_len >= SPEND_LIST_SIZE) {
     return zxerr_unknown;
   }
+  const uint8_t i = transaction_header.outputlist_len;
+  if (i < RAM_LIST_SIZE) {
+    MEMCPY(ram_outputlist[i].rcv, rcv, RANDOM_LEN);
+    MEMCPY(ram_outputlist[i].rcm, rcm, RANDOM_LEN);
+  } else {
+    output_item_t newitem = {0};
+    MEMCPY(newitem.rcv, rcv, RANDOM_LEN);
+    MEMCPY(newitem.rcm, rcm, RANDOM_LEN);
 
-  output_item_t newitem = {0};
-  MEMCPY(newitem.rcv, rcv, RANDOM_LEN);
-  MEMCPY(newitem.rcm, rcm, RANDOM_LEN);
-
-  MEMCPY_NV((void *)&N_outputlist.items[transaction_header.outputlist_len],
-            &newitem, sizeof(output_item_t));
+    MEMCPY_NV((void *)&N_outputlist.items[i], &newitem, sizeof(output_item_t));
+    MEMZERO(&newitem, sizeof(output_item_t));
+    nv_lists_clean = false;
+  }
 
   transaction_header.outputlist_len += 1;
   return zxerr_ok;
@@ -79,21 +113,28 @@ zxerr_t output_append_rand_item(uint8_t *rcv, uint8_t *rcm) {
 output_item_t *outputlist_retrieve_rand_item(uint64_t i) {
   if (transaction_header.outputlist_len <= i) {
     return NULL;
-  } else {
-    return (output_item_t *)&N_outputlist.items[i];
   }
+  if (i < RAM_LIST_SIZE) {
+    return &ram_outputlist[i];
+  }
+  return (output_item_t *)&N_outputlist.items[i];
 }
 
 zxerr_t convert_append_rand_item(uint8_t *rcv) {
   if (transaction_header.convertlist_len >= SPEND_LIST_SIZE) {
     return zxerr_unknown;
   }
+  const uint8_t i = transaction_header.convertlist_len;
+  if (i < RAM_LIST_SIZE) {
+    MEMCPY(ram_convertlist[i].rcv, rcv, RANDOM_LEN);
+  } else {
+    convert_item_t newitem = {0};
+    MEMCPY(newitem.rcv, rcv, RANDOM_LEN);
 
-  convert_item_t newitem = {0};
-  MEMCPY(newitem.rcv, rcv, RANDOM_LEN);
-
-  MEMCPY_NV((void *)&N_convertlist.items[transaction_header.convertlist_len],
-            &newitem, sizeof(convert_item_t));
+    MEMCPY_NV((void *)&N_convertlist.items[i], &newitem, sizeof(convert_item_t));
+    MEMZERO(&newitem, sizeof(convert_item_t));
+    nv_lists_clean = false;
+  }
 
   transaction_header.convertlist_len += 1;
   return zxerr_ok;
@@ -102,9 +143,11 @@ zxerr_t convert_append_rand_item(uint8_t *rcv) {
 convert_item_t *convertlist_retrieve_rand_item(uint8_t i) {
   if (transaction_header.convertlist_len <= i) {
     return NULL;
-  } else {
-    return (convert_item_t *)&N_convertlist.items[i];
   }
+  if (i < RAM_LIST_SIZE) {
+    return &ram_convertlist[i];
+  }
+  return (convert_item_t *)&N_convertlist.items[i];
 }
 
 uint8_t transaction_get_n_spends() {
@@ -159,43 +202,69 @@ void zeroize_signatures() {
   transaction_header.spends_sign_index = 0;
 }
 
-void zeroize_spends() {
-  uint8_t rcv[RANDOM_LEN] = {0};
-  uint8_t alpha[RANDOM_LEN] = {0};
+// Only the NV items past the RAM tier can hold randomness
+static void zeroize_nv_lists() {
+  const spend_item_t spend = {0};
+  const output_item_t output = {0};
+  const convert_item_t convert = {0};
 
-  transaction_header.spendlist_len = 0;
-  for (int i = 0; i < SPEND_LIST_SIZE; i++) {
-    spend_append_rand_item(rcv, alpha);
+  for (int i = RAM_LIST_SIZE; i < SPEND_LIST_SIZE; i++) {
+    MEMCPY_NV((void *)&N_spendlist.items[i], (void *)&spend, sizeof(spend_item_t));
+    MEMCPY_NV((void *)&N_outputlist.items[i], (void *)&output, sizeof(output_item_t));
+    MEMCPY_NV((void *)&N_convertlist.items[i], (void *)&convert, sizeof(convert_item_t));
   }
-  transaction_header.spendlist_len = 0;
+  nv_lists_clean = true;
 }
 
-void zeroize_outputs() {
-  uint8_t rcv[RANDOM_LEN] = {0};
-  uint8_t rcm[RANDOM_LEN] = {0};
+void transaction_reset() {
+    MEMZERO(&transaction_header, sizeof(transaction_header_t));
+    MEMZERO(ram_spendlist, sizeof(ram_spendlist));
+    MEMZERO(ram_outputlist, sizeof(ram_outputlist));
+    MEMZERO(ram_convertlist, sizeof(ram_convertlist));
+    if (!nv_lists_clean) {
+      zeroize_nv_lists();
+    }
+    zeroize_signatures();
+}
 
-  transaction_header.outputlist_len = 0;
-  for (int i = 0; i < SPEND_LIST_SIZE; i++) {
-    output_append_rand_item(rcv, rcm);
+bool diversifier_cache_lookup(const uint8_t tag[DIVERSIFIER_CACHE_TAG_LEN], uint8_t index[DIVERSIFIER_LENGTH]) {
+  if (tag == NULL || index == NULL) {
+    return false;
+  }
+  for (uint8_t i = 0; i < DIVERSIFIER_CACHE_SIZE; i++) {
+    const diversifier_cache_entry_t *entry = (const diversifier_cache_entry_t *)&N_diversifier_cache.entries[i];
+    if (MEMCMP(entry->tag, tag, DIVERSIFIER_CACHE_TAG_LEN) == 0) {
+      MEMCPY(index, entry->index, DIVERSIFIER_LENGTH);
+      return true;
+    }
   }
-  transaction_header.outputlist_len = 0;
+  return false;
 }
 
-void zeroize_converts() {
-  uint8_t rcv[RANDOM_LEN] = {0};
-
-  transaction_header.convertlist_len = 0;
-  for (int i = 0; i < SPEND_LIST_SIZE; i++) {
-    convert_append_rand_item(rcv);
+// Entries are replaced round robin. Flash is only written for new accounts.
+void diversifier_cache_store(const uint8_t tag[DIVERSIFIER_CACHE_TAG_LEN], const uint8_t index[DIVERSIFIER_LENGTH]) {
+  if (tag == NULL || index == NULL) {
+    return;
+  }
+  uint8_t slot = N_diversifier_cache.next % DIVERSIFIER_CACHE_SIZE;
+  for (uint8_t i = 0; i < DIVERSIFIER_CACHE_SIZE; i++) {
+    const diversifier_cache_entry_t *entry = (const diversifier_cache_entry_t *)&N_diversifier_cache.entries[i];
+    if (MEMCMP(entry->tag, tag, DIVERSIFIER_CACHE_TAG_LEN) == 0) {
+      if (MEMCMP(entry->index, index, DIVERSIFIER_LENGTH) == 0) {
+        return;
+      }
+      slot = i;
+      break;
+    }
   }
-  transaction_header.convertlist_len = 0;
-}
 
-void transaction_reset() {
-    MEMZERO(&transaction_header, sizeof(transaction_header_t));
-    zeroize_spends();
-    zeroize_outputs();
-    zeroize_converts();
-    zeroize_signatures();
-}
+  diversifier_cache_entry_t entry = {0};
+  MEMCPY(entry.tag, tag, DIVERSIFIER_CACHE_TAG_LEN);
+  MEMCPY(entry.index, index, DIVERSIFIER_LENGTH);
+  MEMCPY_NV((void *)&N_diversifier_cache.entries[slot], &entry, sizeof(entry));
 
+  if (slot == N_diversifier_cache.next % DIVERSIFIER_CACHE_SIZE) {
+    const uint8_t next = (slot + 1) % DIVERSIFIER_CACHE_SIZE;
+    MEMCPY_NV((void *)&N_diversifier_cache.next, (void *)&next, sizeof(next));
+  }
+}
@@ -21,6 +21,7 @@
 #include "zxmacros.h"
 #include <stdbool.h>
 #include "parser_txdef.h"
+#include "keys_def.h"
 
 #define SPEND_LIST_SIZE 15
 #define SIGNATURE_SIZE 64
@@ -60,6 +61,21 @@ typedef struct {
   uint8_t spend_signatures[SPEND_LIST_SIZE][64];
 } transaction_info_t;
 
+// Index of the first valid diversifier of recently used accounts. Entries are
+// looked up by a one-way tag of the account, so no key material is stored.
+#define DIVERSIFIER_CACHE_SIZE 8
+#define DIVERSIFIER_CACHE_TAG_LEN 16
+
+typedef struct {
+  uint8_t tag[DIVERSIFIER_CACHE_TAG_LEN];
+  uint8_t index[DIVERSIFIER_LENGTH];
+} diversifier_cache_entry_t;
+
+typedef struct {
+  diversifier_cache_entry_t entries[DIVERSIFIER_CACHE_SIZE];
+  uint8_t next;
+} diversifier_cache_t;
+
 zxerr_t spend_append_rand_item(uint8_t *rcv, uint8_t *alpha);
 spend_item_t *spendlist_retrieve_rand_item(uint8_t i);
 zxerr_t output_append_rand_item(uint8_t *rcv, uint8_t *rcm);
@@ -74,3 +90,6 @@ uint8_t transaction_get_n_converts();
 zxerr_t get_next_spend_signature(uint8_t *result);
 zxerr_t spend_signatures_append(uint8_t *signature);
 bool spend_signatures_more_extract();
+
+bool diversifier_cache_lookup(const uint8_t tag[DIVERSIFIER_CACHE_TAG_LEN], uint8_t index[DIVERSIFIER_LENGTH]);
+void diversifier_cache_store(const uint8_t tag[DIVERSIFIER_CACHE_TAG_LEN], const uint8_t index[DIVERSIFIER_LENGTH]);
@@ -19,10 +19,12 @@
 #include "app_mode.h"
 
 #include "parser_impl_common.h"
+#include "parser_print_common.h"
 
 parser_error_t _read(parser_context_t *ctx, parser_tx_t *v) {
 
     CHECK_ERROR(readHeader(ctx, v))
+    CHECK_ERROR(precomputeExpertFields(v))
     CHECK_ERROR(readSections(ctx, v))
 
     CHECK_ERROR(validateTransactionParams(v))
@@ -94,6 +94,8 @@ extern "C" {
 bool isAllZeroes(const void *buf, size_t n);
 
 #define DISCRIMINANT_DATA 0x00
+// Length written by a streamed upload in place of a data body it compacted, followed by the section hash
+#define DATA_SECTION_COMPACTED 0xFFFFFFFFu
 #define DISCRIMINANT_EXTRA_DATA 0x01
 #define DISCRIMINANT_CODE 0x02
 #define DISCRIMINANT_SIGNATURE 0x03
@@ -1070,11 +1070,20 @@ static parser_error_t readDataSection(parser_context_t *ctx, section_t *data) {
     CHECK_ERROR(readSalt(ctx, &data->salt))
     uint32_t tmpValue = 0;
     CHECK_ERROR(readUint32(ctx, &tmpValue));
-    if (tmpValue > UINT16_MAX) {
-        return parser_value_out_of_range;
+    if (tmpValue == DATA_SECTION_COMPACTED) {
+        // Only a streamed upload writes the section hash in place of the body
+        if (!ctx->tx_obj->transaction.streamed) {
+            return parser_unexpected_value;
+        }
+        CHECK_ERROR(readBytesSize(ctx, data->bytes_hash, HASH_LEN))
+        data->compacted = true;
+    } else {
+        if (tmpValue > UINT16_MAX) {
+            return parser_value_out_of_range;
+        }
+        data->bytes.len = (uint16_t)tmpValue;
+        CHECK_ERROR(readBytes(ctx, &data->bytes.ptr, data->bytes.len))
     }
-    data->bytes.len = (uint16_t)tmpValue;
-    CHECK_ERROR(readBytes(ctx, &data->bytes.ptr, data->bytes.len))
 
     // Must make sure that header dataHash refers to this section's hash
     uint8_t dataHash[HASH_LEN] = {0};
@@ -1232,6 +1241,10 @@ parser_error_t validateTransactionParams(parser_tx_t *txObj) {
 
     CHECK_ERROR(readTransactionType(&txObj->transaction.sections.code.tag, &txObj->typeTx))
     const section_t *data = &txObj->transaction.sections.data;
+    // Only transactions that do not show their data can sign it by hash
+    if (data->compacted && txObj->typeTx != Custom) {
+        return parser_unexpected_value;
+    }
     switch (txObj->typeTx) {
         case Bond:
         case Unbond:
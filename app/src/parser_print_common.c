@@ -22,16 +22,19 @@
 #include "timeutils.h"
 
 #include "coin.h"
-#include "bech32.h"
 #include "bignum.h"
 #include "parser_address.h"
 #include "crypto_helper.h"
+#include "app_mode.h"
 
 #define PREFIX "yay with councils:\n"
 #define PREFIX_COUNCIL "Council: "
 #define PREFIX_SPENDING "spending cap: "
 
 
+// Up to 79 digits, sign, decimal point and symbol
+#define AMOUNT_STR_LEN 325
+
 #define CHECK_PTR_BOUNDS(count, dstLen)    \
     if((count + 1) >= dstLen) {             \
         return parser_decimal_too_big;     \
@@ -111,70 +114,176 @@ parser_error_t printCodeHash(section_t *codeSection,
     return parser_ok;
 }
 
-static parser_error_t printTimestamp(const bytes_t timestamp,
-                                     char *outVal, uint16_t outValLen,
-                                     uint8_t pageIdx, uint8_t *pageCount) {
-
-
+static parser_error_t formatTimestamp(const bytes_t timestamp, char *output, uint16_t outputLen) {
     // Received         "2023-04-19T14:19:38.114481351+00:00"
     // Expected         "2023-04-19 14:19:38.114481351 UTC"
     if (timestamp.len > 38 || timestamp.len < 25) {
         return parser_unexpected_value;
     }
 
-    char date[55] = {0};
-    uint32_t offset = timestamp.len - 6;
-    memcpy(date, timestamp.ptr, timestamp.len - 6);
-    snprintf(date + offset, sizeof(date) - offset, " UTC");
+    const uint16_t dateLen = timestamp.len - 6;
+    if (output == NULL || outputLen < dateLen + sizeof(" UTC")) {
+        return parser_unexpected_buffer_end;
+    }
+    memcpy(output, timestamp.ptr, dateLen);
+    memcpy(output + dateLen, " UTC", sizeof(" UTC"));
     // Replace date-time separator with space
-    char * const separator = strchr(date, 'T');
+    char * const separator = strchr(output, 'T');
     if (separator != NULL) {
       *separator = ' ';
     }
+    return parser_ok;
+}
 
+static parser_error_t printTimestamp(const bytes_t timestamp,
+                                     char *outVal, uint16_t outValLen,
+                                     uint8_t pageIdx, uint8_t *pageCount) {
+    char date[55] = {0};
+    CHECK_ERROR(formatTimestamp(timestamp, date, sizeof(date)))
     pageString(outVal, outValLen, date, pageIdx, pageCount);
     return parser_ok;
 }
 
-parser_error_t printAmount( const bytes_t *amount, bool isSigned, uint8_t amountDenom, const char* symbol,
-                            char *outVal, uint16_t outValLen,
-                            uint8_t pageIdx, uint8_t *pageCount) {
-
+// strAmount must hold AMOUNT_STR_LEN chars
+static parser_error_t formatAmount(const bytes_t *amount, bool isSigned, uint8_t amountDenom, const char* symbol,
+                                   char *strAmount, uint16_t strAmountLen) {
+    if (strAmount == NULL || strAmountLen < AMOUNT_STR_LEN) {
+        return parser_unexpected_buffer_end;
+    }
 
-    char strAmount[325] = {0};
-    CHECK_ERROR(bigint_to_str(amount, isSigned, strAmount, sizeof(strAmount), 0, pageCount))
+    uint8_t pageCount = 0;
+    CHECK_ERROR(bigint_to_str(amount, isSigned, strAmount, strAmountLen, 0, &pageCount))
     const uint8_t isNegative = strAmount[0] == '-' ? 1 : 0;
 
-    if (insertDecimalPoint(strAmount + isNegative, sizeof(strAmount) - isNegative, amountDenom) != zxerr_ok) {
+    if (insertDecimalPoint(strAmount + isNegative, strAmountLen - isNegative, amountDenom) != zxerr_ok) {
         return parser_unexpected_error;
     }
     //const char *suffix = (amountDenom == 0) ? ".0" : "";
-    z_str3join(strAmount, sizeof(strAmount), symbol, "");
+    z_str3join(strAmount, strAmountLen, symbol, "");
     number_inplace_trimming(strAmount, 1);
+    return parser_ok;
+}
+
+parser_error_t printAmount( const bytes_t *amount, bool isSigned, uint8_t amountDenom, const char* symbol,
+                            char *outVal, uint16_t outValLen,
+                            uint8_t pageIdx, uint8_t *pageCount) {
+
+
+    char strAmount[AMOUNT_STR_LEN] = {0};
+    CHECK_ERROR(formatAmount(amount, isSigned, amountDenom, symbol, strAmount, sizeof(strAmount)))
     pageString(outVal, outValLen, strAmount, pageIdx, pageCount);
 
     return parser_ok;
 }
 
+static parser_error_t formatPublicKey(const bytes_t *pubkey, char *output, uint16_t outputLen) {
+    if (crypto_encodePubkey(pubkey->ptr, pubkey->len, output, outputLen) != zxerr_ok) {
+        return parser_unexpected_error;
+    }
+    return parser_ok;
+}
+
 parser_error_t printPublicKey( const bytes_t *pubkey,
                             char *outVal, uint16_t outValLen,
                             uint8_t pageIdx, uint8_t *pageCount) {
     char bech32String[85] = {0};
-    const zxerr_t err = bech32EncodeFromBytes(bech32String,
-                        sizeof(bech32String),
-                        "tpknam",
-                        (uint8_t*) pubkey->ptr,
-                        pubkey->len,
-                        1,
-                        BECH32_ENCODING_BECH32M);
-
-    if (err != zxerr_ok) {
-        return parser_unexpected_error;
-    }
+    CHECK_ERROR(formatPublicKey(pubkey, bech32String, sizeof(bech32String)))
     pageString(outVal, outValLen, (const char*) &bech32String, pageIdx, pageCount);
     return parser_ok;
 }
 
+#if defined(EXPERT_FIELDS_CACHE)
+static parser_error_t formatExpertField(const parser_tx_t *v, expert_field_e field, char *output, uint16_t outputLen) {
+    const header_t *header = &v->transaction.header;
+    switch (field) {
+        case ExpertTimestamp:
+            return formatTimestamp(v->transaction.timestamp, output, outputLen);
+        case ExpertPubkey:
+            return formatPublicKey(&header->pubkey, output, outputLen);
+        case ExpertGasLimit:
+            if (uint64_to_str(output, outputLen, header->gasLimit) != NULL) {
+                return parser_unexpected_buffer_end;
+            }
+            return parser_ok;
+        case ExpertFeeAmount: {
+            char strAmount[AMOUNT_STR_LEN] = {0};
+            CHECK_ERROR(formatAmount(&header->fees.amount, true, header->fees.denom, "", strAmount, sizeof(strAmount)))
+            const size_t amountLen = strnlen(strAmount, sizeof(strAmount));
+            if (amountLen >= outputLen) {
+                return parser_unexpected_buffer_end;
+            }
+            memcpy(output, strAmount, amountLen + 1);
+            return parser_ok;
+        }
+        case ExpertFeeToken:
+            // Only shown when the token has no known symbol
+            if (header->fees.symbol != NULL) {
+                return parser_no_data;
+            }
+            return crypto_encodeAltAddress(&header->fees.address, output, outputLen);
+        default:
+            return parser_unexpected_value;
+    }
+}
+#endif
+
+parser_error_t precomputeExpertFields(parser_tx_t *v) {
+    if (v == NULL) {
+        return parser_unexpected_value;
+    }
+
+#if defined(EXPERT_FIELDS_CACHE)
+    expert_fields_t *expert = &v->transaction.header.expert;
+    for (uint8_t field = 0; field < ExpertFieldsCount; field++) {
+        expert->offset[field] = EXPERT_FIELD_NONE;
+    }
+    // The fields are only shown in expert mode
+    if (!app_mode_expert()) {
+        return parser_ok;
+    }
+
+    MEMZERO(expert->buffer, sizeof(expert->buffer));
+    uint16_t used = 0;
+    for (uint8_t field = 0; field < ExpertFieldsCount; field++) {
+        if (used >= sizeof(expert->buffer)) {
+            continue;
+        }
+
+        char *output = expert->buffer + used;
+        const uint16_t outputLen = sizeof(expert->buffer) - used;
+        // Errors are left for printExpert to report when the field is shown
+        if (formatExpertField(v, (expert_field_e)field, output, outputLen) != parser_ok) {
+            MEMZERO(output, outputLen);
+            continue;
+        }
+        expert->offset[field] = used;
+        used += strnlen(output, outputLen) + 1;
+    }
+#endif
+    return parser_ok;
+}
+
+static bool pageExpertField(const header_t *header, expert_field_e field,
+                            char *outVal, uint16_t outValLen,
+                            uint8_t pageIdx, uint8_t *pageCount) {
+#if defined(EXPERT_FIELDS_CACHE)
+    const uint16_t offset = header->expert.offset[field];
+    if (offset == EXPERT_FIELD_NONE) {
+        return false;
+    }
+    pageString(outVal, outValLen, header->expert.buffer + offset, pageIdx, pageCount);
+    return true;
+#else
+    (void)header;
+    (void)field;
+    (void)outVal;
+    (void)outValLen;
+    (void)pageIdx;
+    (void)pageCount;
+    return false;
+#endif
+}
+
 parser_error_t joinStrings(const bytes_t first, const bytes_t second, const char *separator,
                             char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
 
@@ -408,37 +517,48 @@ parser_error_t printExpert( const parser_context_t *ctx,
         displayIdx++;
     }
 
+    const header_t *header = &ctx->tx_obj->transaction.header;
     switch (displayIdx) {
         case 0:
             snprintf(outKey, outKeyLen, "Timestamp");
-            CHECK_ERROR(printTimestamp(ctx->tx_obj->transaction.timestamp,
-                                       outVal, outValLen, pageIdx, pageCount))
+            if (!pageExpertField(header, ExpertTimestamp, outVal, outValLen, pageIdx, pageCount)) {
+                CHECK_ERROR(printTimestamp(ctx->tx_obj->transaction.timestamp,
+                                           outVal, outValLen, pageIdx, pageCount))
+            }
             break;
         case 1: {
-            const bytes_t *pubkey = &ctx->tx_obj->transaction.header.pubkey;
             snprintf(outKey, outKeyLen, "Pubkey");
-            CHECK_ERROR(printPublicKey(pubkey, outVal, outValLen, pageIdx, pageCount));
+            if (!pageExpertField(header, ExpertPubkey, outVal, outValLen, pageIdx, pageCount)) {
+                CHECK_ERROR(printPublicKey(&header->pubkey, outVal, outValLen, pageIdx, pageCount));
+            }
             break;
         }
         case 2:
             snprintf(outKey, outKeyLen, "Gas limit");
-            if (uint64_to_str(outVal, outValLen, ctx->tx_obj->transaction.header.gasLimit) != NULL) {
+            if (!pageExpertField(header, ExpertGasLimit, outVal, outValLen, pageIdx, pageCount) &&
+                uint64_to_str(outVal, outValLen, header->gasLimit) != NULL) {
                 return parser_unexpected_error;
             }
             break;
         case 3: {
-            if(ctx->tx_obj->transaction.header.fees.symbol != NULL) {
+            if(header->fees.symbol != NULL) {
                 snprintf(outKey, outKeyLen, "Fees/gas unit");
-                CHECK_ERROR(printAmount(&ctx->tx_obj->transaction.header.fees.amount, true, ctx->tx_obj->transaction.header.fees.denom, "", outVal, outValLen, pageIdx, pageCount))
+                if (!pageExpertField(header, ExpertFeeAmount, outVal, outValLen, pageIdx, pageCount)) {
+                    CHECK_ERROR(printAmount(&header->fees.amount, true, header->fees.denom, "", outVal, outValLen, pageIdx, pageCount))
+                }
             } else {
                 snprintf(outKey, outKeyLen, "Fee token");
-                CHECK_ERROR(printAddressAlt(&ctx->tx_obj->transaction.header.fees.address, outVal, outValLen, pageIdx, pageCount))
+                if (!pageExpertField(header, ExpertFeeToken, outVal, outValLen, pageIdx, pageCount)) {
+                    CHECK_ERROR(printAddressAlt(&header->fees.address, outVal, outValLen, pageIdx, pageCount))
+                }
             }
             break;
         }
         case 4: {
             snprintf(outKey, outKeyLen, "Fees/gas unit");
-            CHECK_ERROR(printAmount(&ctx->tx_obj->transaction.header.fees.amount, true, ctx->tx_obj->transaction.header.fees.denom, "", outVal, outValLen, pageIdx, pageCount))
+            if (!pageExpertField(header, ExpertFeeAmount, outVal, outValLen, pageIdx, pageCount)) {
+                CHECK_ERROR(printAmount(&header->fees.amount, true, header->fees.denom, "", outVal, outValLen, pageIdx, pageCount))
+            }
             break;
         }
         default:
@@ -35,6 +35,9 @@ parser_error_t printMemo( const parser_context_t *ctx,
                         char *outVal, uint16_t outValLen,
                         uint8_t pageIdx, uint8_t *pageCount);
 
+// Renders the expert mode header fields into header.expert, called once the header is read
+parser_error_t precomputeExpertFields(parser_tx_t *v);
+
 parser_error_t printExpert(const parser_context_t *ctx,
                            uint8_t displayIdx,
                            char *outKey, uint16_t outKeyLen,
@@ -231,8 +231,33 @@ typedef struct {
     uint8_t bytes_hash[HASH_LEN];
     bytes_t tag;
     uint8_t idx;
+    // Data body left out by a streamed upload, bytes_hash holds the section hash
+    bool compacted;
 } section_t;
 
+// Header fields shown in expert mode, rendered once after the header is read and
+// stored back to back. A field that does not fit is rendered when it is shown.
+// Nano S has no RAM to spare for them and renders every field when it is shown.
+#if !defined(TARGET_NANOS)
+#define EXPERT_FIELDS_CACHE
+#endif
+#define EXPERT_FIELDS_BUFFER_LEN 256
+#define EXPERT_FIELD_NONE UINT16_MAX
+
+typedef enum {
+    ExpertTimestamp = 0,
+    ExpertPubkey,
+    ExpertGasLimit,
+    ExpertFeeAmount,
+    ExpertFeeToken,
+    ExpertFieldsCount,
+} expert_field_e;
+
+typedef struct {
+    uint16_t offset[ExpertFieldsCount];
+    char buffer[EXPERT_FIELDS_BUFFER_LEN];
+} expert_fields_t;
+
 typedef struct {
     bytes_t extBytes;
     bytes_t bytes;
@@ -245,6 +270,9 @@ typedef struct {
     bytes_t memoHash;
     const section_t *memoSection;
     uint8_t atomic;
+#if defined(EXPERT_FIELDS_CACHE)
+    expert_fields_t expert;
+#endif
 } header_t;
 typedef struct {
     uint32_t sectionLen;
@@ -264,6 +292,7 @@ typedef struct {
     header_t header;
     sections_t sections;
     bool isMasp;
+    bool streamed;
 } transaction_t;
 
 
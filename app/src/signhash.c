@@ -15,7 +15,7 @@
  ********************************************************************************/
 
 #include "signhash.h"
-#include "cx.h"
+#include "hashing.h"
 #include <zxformat.h>
 #include <zxmacros.h>
 #include "tx_hash.h"
@@ -29,11 +29,11 @@ zxerr_t signature_hash(const parser_tx_t *txObj, uint8_t *output) {
     return zxerr_no_data;
   }
 
-  cx_blake2b_t ctx = {0};
+  hash_blake2b_t ctx;
 
   uint8_t personalization[16] = "ZcashTxHash_";
   MEMCPY(personalization + 12, CONSENSUS_BRANCH_ID, 4);
-  CHECK_CX_OK(cx_blake2b_init2_no_throw(&ctx, 256, NULL, 0, (uint8_t *)personalization, PERSONALIZATION_SIZE));
+  CHECK_ZXERR(hash_blake2b_init(&ctx, HASH_SIZE, personalization, PERSONALIZATION_SIZE));
 
   uint8_t header_digest[32] = {0};
   uint8_t transparent_digest[32] = {0};
@@ -43,9 +43,10 @@ zxerr_t signature_hash(const parser_tx_t *txObj, uint8_t *output) {
   CHECK_ZXERR(tx_hash_transparent_data(txObj, transparent_digest));
   CHECK_ZXERR(tx_hash_sapling_data(txObj, sapling_digest));
 
-  CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, header_digest, HASH_SIZE, NULL, 0));
-  CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, transparent_digest, HASH_SIZE, NULL, 0));
-  CHECK_CX_OK(cx_hash_no_throw(&ctx.header, CX_LAST, sapling_digest, HASH_SIZE, output, HASH_SIZE));
+  CHECK_ZXERR(hash_blake2b_update(&ctx, header_digest, HASH_SIZE));
+  CHECK_ZXERR(hash_blake2b_update(&ctx, transparent_digest, HASH_SIZE));
+  CHECK_ZXERR(hash_blake2b_update(&ctx, sapling_digest, HASH_SIZE));
+  CHECK_ZXERR(hash_blake2b_final(&ctx, output));
 
   return zxerr_ok;
 }
@@ -16,8 +16,16 @@
 
 #pragma once
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #include <stdint.h>
 #include "zxerror.h"
 #include "parser_txdef.h"
 
 zxerr_t signature_hash(const parser_tx_t *txObj, uint8_t *output);
+
+#ifdef __cplusplus
+}
+#endif
@@ -14,8 +14,7 @@
  *  limitations under the License.
  ********************************************************************************/
 #include "tx_hash.h"
-#include "cx.h"
-#include "cx.h"
+#include "hashing.h"
 #include <zxformat.h>
 #include <zxmacros.h>
 #include "parser_txdef.h"
@@ -26,15 +25,16 @@ zxerr_t tx_hash_header_data(const parser_tx_t *txObj, uint8_t *output) {
         return zxerr_no_data;
     }
 
-    cx_blake2b_t ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&ctx, 256, NULL, 0, (uint8_t*)ZCASH_HEADERS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
+    hash_blake2b_t ctx;
+    CHECK_ZXERR(hash_blake2b_init(&ctx, HASH_SIZE, (const uint8_t *)ZCASH_HEADERS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
 
     masp_tx_data_t *maspTx = (masp_tx_data_t *)&txObj->transaction.sections.maspTx.data;
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, (const uint8_t *)&maspTx->tx_version, 4, NULL, 0));
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, (const uint8_t *)&maspTx->version_group_id, 4, NULL, 0));
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, (const uint8_t *)&maspTx->consensus_branch_id, 4, NULL, 0));
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, (const uint8_t *)&maspTx->lock_time, 4, NULL, 0));
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, CX_LAST, (const uint8_t *)&maspTx->expiry_height, 4, output, HASH_SIZE));
+    CHECK_ZXERR(hash_blake2b_update(&ctx, (const uint8_t *)&maspTx->tx_version, 4));
+    CHECK_ZXERR(hash_blake2b_update(&ctx, (const uint8_t *)&maspTx->version_group_id, 4));
+    CHECK_ZXERR(hash_blake2b_update(&ctx, (const uint8_t *)&maspTx->consensus_branch_id, 4));
+    CHECK_ZXERR(hash_blake2b_update(&ctx, (const uint8_t *)&maspTx->lock_time, 4));
+    CHECK_ZXERR(hash_blake2b_update(&ctx, (const uint8_t *)&maspTx->expiry_height, 4));
+    CHECK_ZXERR(hash_blake2b_final(&ctx, output));
 
     return zxerr_ok;
 }
@@ -48,22 +48,22 @@ zxerr_t tx_hash_transparent_inputs(const parser_tx_t *txObj, uint8_t *output) {
         return zxerr_no_data;
     }
 
-    cx_blake2b_t ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&ctx, 256, NULL, 0, (uint8_t*)ZCASH_INPUTS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
+    hash_blake2b_t ctx;
+    CHECK_ZXERR(hash_blake2b_init(&ctx, HASH_SIZE, (const uint8_t *)ZCASH_INPUTS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
 
     if(txObj->transaction.sections.maspTx.data.transparent_bundle.n_vin == 0){
-        CHECK_CX_OK(cx_hash_no_throw(&ctx.header, CX_LAST, 0, 0, output, HASH_SIZE));
+        CHECK_ZXERR(hash_blake2b_final(&ctx, output));
         return zxerr_ok;
     }
 
     const uint8_t *vin = txObj->transaction.sections.maspTx.data.transparent_bundle.vin.ptr;
 
     for(uint64_t i = 0; i < txObj->transaction.sections.maspTx.data.transparent_bundle.n_vin; i++, vin += VIN_LEN){
-        CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, vin, ASSET_ID_LEN, NULL, 0));
-        CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, vin + VIN_VALUE_OFFSET, sizeof(uint64_t), NULL, 0));
-        CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, vin + VIN_ADDR_OFFSET, IMPLICIT_ADDR_LEN, NULL, 0));
+        CHECK_ZXERR(hash_blake2b_update(&ctx, vin, ASSET_ID_LEN));
+        CHECK_ZXERR(hash_blake2b_update(&ctx, vin + VIN_VALUE_OFFSET, sizeof(uint64_t)));
+        CHECK_ZXERR(hash_blake2b_update(&ctx, vin + VIN_ADDR_OFFSET, IMPLICIT_ADDR_LEN));
     }
-    CHECK_CX_OK(cx_hash_final(&ctx.header, output));
+    CHECK_ZXERR(hash_blake2b_final(&ctx, output));
 
     return zxerr_ok;
 
@@ -78,21 +78,21 @@ zxerr_t tx_hash_transparent_outputs(const parser_tx_t *txObj, uint8_t *output) {
         return zxerr_no_data;
     }
 
-    cx_blake2b_t ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&ctx, 256, NULL, 0, (uint8_t*)ZCASH_OUTPUTS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
+    hash_blake2b_t ctx;
+    CHECK_ZXERR(hash_blake2b_init(&ctx, HASH_SIZE, (const uint8_t *)ZCASH_OUTPUTS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
 
     if(txObj->transaction.sections.maspTx.data.transparent_bundle.n_vout == 0){
-        CHECK_CX_OK(cx_hash_no_throw(&ctx.header, CX_LAST, 0, 0, output, HASH_SIZE));
+        CHECK_ZXERR(hash_blake2b_final(&ctx, output));
         return zxerr_ok;
     }
 
     const uint8_t *vout = txObj->transaction.sections.maspTx.data.transparent_bundle.vout.ptr;
 
     for(uint64_t i = 0; i < txObj->transaction.sections.maspTx.data.transparent_bundle.n_vout; i++, vout += VOUT_LEN){
-        CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, vout, VOUT_LEN, NULL, 0));
+        CHECK_ZXERR(hash_blake2b_update(&ctx, vout, VOUT_LEN));
     }
 
-    CHECK_CX_OK(cx_hash_final(&ctx.header, output));
+    CHECK_ZXERR(hash_blake2b_final(&ctx, output));
 
     return zxerr_ok;
 
@@ -108,38 +108,37 @@ zxerr_t tx_hash_sapling_spends(const parser_tx_t *txObj, uint8_t *output) {
         return zxerr_no_data;
     }
 
-    cx_blake2b_t ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&ctx, 256, NULL, 0, (uint8_t*)ZCASH_SAPLING_SPENDS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
+    hash_blake2b_t ctx;
+    CHECK_ZXERR(hash_blake2b_init(&ctx, HASH_SIZE, (const uint8_t *)ZCASH_SAPLING_SPENDS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
 
     if(txObj->transaction.sections.maspTx.data.sapling_bundle.n_shielded_spends == 0){
-        CHECK_CX_OK(cx_hash_no_throw(&ctx.header, CX_LAST, 0, 0, output, HASH_SIZE));
+        CHECK_ZXERR(hash_blake2b_final(&ctx, output));
         return zxerr_ok;
     }
 
-    cx_blake2b_t nullifier_ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&nullifier_ctx, 256, NULL, 0, (uint8_t*)ZCASH_SAPLING_SPENDS_COMPACT_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
-
-    cx_blake2b_t nc_ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&nc_ctx, 256, NULL, 0, (uint8_t*)ZCASH_SAPLING_SPENDS_NONCOMPACT_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
+    // The nullifier and non-compact digests are independent streams, hashed as lanes
+    enum { NULLIFIER_LANE, NONCOMPACT_LANE, SPEND_LANES };
+    const char *const personalizations[SPEND_LANES] = {ZCASH_SAPLING_SPENDS_COMPACT_HASH_PERSONALIZATION,
+                                                       ZCASH_SAPLING_SPENDS_NONCOMPACT_HASH_PERSONALIZATION};
+    hash_blake2b_lanes_t lanes;
+    CHECK_ZXERR(hash_blake2b_lanes_init(&lanes, SPEND_LANES, HASH_SIZE, personalizations, PERSONALIZATION_SIZE));
 
     const uint8_t *spend = txObj->transaction.sections.maspTx.data.sapling_bundle.shielded_spends.ptr;
 
     for(uint64_t i = 0; i < txObj->transaction.sections.maspTx.data.sapling_bundle.n_shielded_spends; i++, spend += SHIELDED_SPENDS_LEN){
-        CHECK_CX_OK(cx_hash_no_throw(&nullifier_ctx.header, 0, spend + CV_LEN, NULLIFIER_LEN, NULL,0));
+        CHECK_ZXERR(hash_blake2b_lanes_update(&lanes, NULLIFIER_LANE, spend + CV_LEN, NULLIFIER_LEN));
 
-        CHECK_CX_OK(cx_hash_no_throw(&nc_ctx.header, 0, spend, CV_LEN, NULL, 0));
-        CHECK_CX_OK(cx_hash_no_throw(&nc_ctx.header, 0, txObj->transaction.sections.maspTx.data.sapling_bundle.anchor_shielded_spends.ptr, ANCHOR_LEN, NULL, 0));
-        CHECK_CX_OK(cx_hash_no_throw(&nc_ctx.header, 0, spend + CV_LEN + NULLIFIER_LEN, RK_LEN, NULL, 0));
+        CHECK_ZXERR(hash_blake2b_lanes_update(&lanes, NONCOMPACT_LANE, spend, CV_LEN));
+        CHECK_ZXERR(hash_blake2b_lanes_update(&lanes, NONCOMPACT_LANE, txObj->transaction.sections.maspTx.data.sapling_bundle.anchor_shielded_spends.ptr, ANCHOR_LEN));
+        CHECK_ZXERR(hash_blake2b_lanes_update(&lanes, NONCOMPACT_LANE, spend + CV_LEN + NULLIFIER_LEN, RK_LEN));
     }
 
-    uint8_t nullifier_hash[HASH_SIZE] = {0};
-    uint8_t nc_hash[HASH_SIZE] = {0};
-
-    CHECK_CX_OK(cx_hash_final(&nullifier_ctx.header, nullifier_hash));
-    CHECK_CX_OK(cx_hash_final(&nc_ctx.header, nc_hash));
+    // nullifier_hash || nc_hash
+    uint8_t lane_hashes[SPEND_LANES * HASH_SIZE] = {0};
+    CHECK_ZXERR(hash_blake2b_lanes_final(&lanes, lane_hashes));
 
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, nullifier_hash, HASH_SIZE, NULL, 0));
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, CX_LAST, nc_hash, HASH_SIZE, output, HASH_SIZE));
+    CHECK_ZXERR(hash_blake2b_update(&ctx, lane_hashes, sizeof(lane_hashes)));
+    CHECK_ZXERR(hash_blake2b_final(&ctx, output));
 
     return zxerr_ok;
 }
@@ -152,22 +151,22 @@ zxerr_t tx_hash_sapling_converts(const parser_tx_t *txObj, uint8_t *output) {
         return zxerr_no_data;
     }
 
-    cx_blake2b_t ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&ctx, 256, NULL, 0, (uint8_t*)ZCASH_SAPLING_CONVERTS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
+    hash_blake2b_t ctx;
+    CHECK_ZXERR(hash_blake2b_init(&ctx, HASH_SIZE, (const uint8_t *)ZCASH_SAPLING_CONVERTS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
 
     if(txObj->transaction.sections.maspTx.data.sapling_bundle.n_shielded_converts == 0){
-        CHECK_CX_OK(cx_hash_no_throw(&ctx.header, CX_LAST, 0, 0, output, HASH_SIZE));
+        CHECK_ZXERR(hash_blake2b_final(&ctx, output));
         return zxerr_ok;
     }
 
     const uint8_t *spend = txObj->transaction.sections.maspTx.data.sapling_bundle.shielded_converts.ptr;
 
     for(uint64_t i = 0; i < txObj->transaction.sections.maspTx.data.sapling_bundle.n_shielded_converts; i++, spend += SHIELDED_CONVERTS_LEN){
-        CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, spend, CV_LEN, NULL,0));
-        CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, txObj->transaction.sections.maspTx.data.sapling_bundle.anchor_shielded_converts.ptr, ANCHOR_LEN, NULL, 0));
+        CHECK_ZXERR(hash_blake2b_update(&ctx, spend, CV_LEN));
+        CHECK_ZXERR(hash_blake2b_update(&ctx, txObj->transaction.sections.maspTx.data.sapling_bundle.anchor_shielded_converts.ptr, ANCHOR_LEN));
     }
 
-    CHECK_CX_OK(cx_hash_final(&ctx.header, output));
+    CHECK_ZXERR(hash_blake2b_final(&ctx, output));
 
     return zxerr_ok;
 }
@@ -183,50 +182,44 @@ zxerr_t tx_hash_sapling_outputs(const parser_tx_t *txObj, uint8_t *output) {
         return zxerr_no_data;
     }
 
-    cx_blake2b_t ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&ctx, 256, NULL, 0, (uint8_t*)ZCASH_SAPLING_OUTPUTS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
+    hash_blake2b_t ctx;
+    CHECK_ZXERR(hash_blake2b_init(&ctx, HASH_SIZE, (const uint8_t *)ZCASH_SAPLING_OUTPUTS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
 
     if(txObj->transaction.sections.maspTx.data.sapling_bundle.n_shielded_outputs == 0){
-        CHECK_CX_OK(cx_hash_no_throw(&ctx.header, CX_LAST, 0, 0, output, HASH_SIZE));
+        CHECK_ZXERR(hash_blake2b_final(&ctx, output));
         return zxerr_ok;
     }
 
-    cx_blake2b_t compact_ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&compact_ctx, 256, NULL, 0, (uint8_t*)ZCASH_SAPLING_OUTPUTS_COMPACT_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
-
-    cx_blake2b_t memo_ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&memo_ctx, 256, NULL, 0, (uint8_t*)ZCASH_SAPLING_OUTPUTS_MEMOS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
-
-    cx_blake2b_t non_compact_ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&non_compact_ctx, 256, NULL, 0, (uint8_t*)ZCASH_SAPLING_OUTPUTS_NONCOMPACT_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
+    // The compact, memo and non-compact digests are independent streams, hashed as lanes
+    enum { COMPACT_LANE, MEMO_LANE, NONCOMPACT_LANE, OUTPUT_LANES };
+    const char *const personalizations[OUTPUT_LANES] = {ZCASH_SAPLING_OUTPUTS_COMPACT_HASH_PERSONALIZATION,
+                                                        ZCASH_SAPLING_OUTPUTS_MEMOS_HASH_PERSONALIZATION,
+                                                        ZCASH_SAPLING_OUTPUTS_NONCOMPACT_HASH_PERSONALIZATION};
+    hash_blake2b_lanes_t lanes;
+    CHECK_ZXERR(hash_blake2b_lanes_init(&lanes, OUTPUT_LANES, HASH_SIZE, personalizations, PERSONALIZATION_SIZE));
 
     const uint8_t *out = txObj->transaction.sections.maspTx.data.sapling_bundle.shielded_outputs.ptr;
 
     for (uint64_t i = 0; i < txObj->transaction.sections.maspTx.data.sapling_bundle.n_shielded_outputs; i++, out += SHIELDED_OUTPUTS_LEN) {
-        CHECK_CX_OK(cx_hash_no_throw(&compact_ctx.header, 0, out + CMU_OFFSET, CMU_LEN, NULL,0));
-        CHECK_CX_OK(cx_hash_no_throw(&compact_ctx.header, 0, out + EPK_OFFSET, EPK_OFFSET, NULL,0));
-        CHECK_CX_OK(cx_hash_no_throw(&compact_ctx.header, 0, out + ENC_CIPHER_OFFSET, COMPACT_NOTE_SIZE, NULL,0));
+        CHECK_ZXERR(hash_blake2b_lanes_update(&lanes, COMPACT_LANE, out + CMU_OFFSET, CMU_LEN));
+        CHECK_ZXERR(hash_blake2b_lanes_update(&lanes, COMPACT_LANE, out + EPK_OFFSET, EPK_OFFSET));
+        CHECK_ZXERR(hash_blake2b_lanes_update(&lanes, COMPACT_LANE, out + ENC_CIPHER_OFFSET, COMPACT_NOTE_SIZE));
 
-        CHECK_CX_OK(cx_hash_no_throw(&memo_ctx.header, 0,out + ENC_CIPHER_OFFSET + COMPACT_NOTE_SIZE, NOTE_PLAINTEXT_SIZE, NULL,0));
+        CHECK_ZXERR(hash_blake2b_lanes_update(&lanes, MEMO_LANE, out + ENC_CIPHER_OFFSET + COMPACT_NOTE_SIZE, NOTE_PLAINTEXT_SIZE));
 
-        CHECK_CX_OK(cx_hash_no_throw(&non_compact_ctx.header, 0, out, CV_LEN, NULL,0));
-        CHECK_CX_OK(cx_hash_no_throw(&non_compact_ctx.header, 0, out + ENC_CIPHER_OFFSET + COMPACT_NOTE_SIZE + NOTE_PLAINTEXT_SIZE ,
-                    ENC_CIPHER_LEN - (COMPACT_NOTE_SIZE + NOTE_PLAINTEXT_SIZE), NULL, 0));
-        CHECK_CX_OK(cx_hash_no_throw(&non_compact_ctx.header, 0, out + OUT_CIPHER_OFFSET, OUT_CIPHER_LEN, NULL,0));
+        CHECK_ZXERR(hash_blake2b_lanes_update(&lanes, NONCOMPACT_LANE, out, CV_LEN));
+        CHECK_ZXERR(hash_blake2b_lanes_update(&lanes, NONCOMPACT_LANE, out + ENC_CIPHER_OFFSET + COMPACT_NOTE_SIZE + NOTE_PLAINTEXT_SIZE ,
+                    ENC_CIPHER_LEN - (COMPACT_NOTE_SIZE + NOTE_PLAINTEXT_SIZE)));
+        CHECK_ZXERR(hash_blake2b_lanes_update(&lanes, NONCOMPACT_LANE, out + OUT_CIPHER_OFFSET, OUT_CIPHER_LEN));
 
     }
 
-    uint8_t compact_hash[HASH_SIZE] = {0};
-    uint8_t memo_hash[HASH_SIZE] = {0};
-    uint8_t non_compact_hash[HASH_SIZE] = {0};
-
-    CHECK_CX_OK(cx_hash_final(&compact_ctx.header, compact_hash));
-    CHECK_CX_OK(cx_hash_final(&memo_ctx.header, memo_hash));
-    CHECK_CX_OK(cx_hash_final(&non_compact_ctx.header, non_compact_hash));
+    // compact_hash || memo_hash || non_compact_hash
+    uint8_t lane_hashes[OUTPUT_LANES * HASH_SIZE] = {0};
+    CHECK_ZXERR(hash_blake2b_lanes_final(&lanes, lane_hashes));
 
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, compact_hash, HASH_SIZE, NULL, 0));
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, memo_hash, HASH_SIZE, NULL, 0));
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, CX_LAST, non_compact_hash, HASH_SIZE, output, HASH_SIZE));
+    CHECK_ZXERR(hash_blake2b_update(&ctx, lane_hashes, sizeof(lane_hashes)));
+    CHECK_ZXERR(hash_blake2b_final(&ctx, output));
 
     return zxerr_ok;
 }
@@ -236,8 +229,8 @@ zxerr_t tx_hash_sapling_data(const parser_tx_t *txObj, uint8_t *output) {
         return zxerr_no_data;
     }
 
-    cx_blake2b_t ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&ctx, 256, NULL, 0, (uint8_t*)ZCASH_SAPLING_OUTPUTS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
+    hash_blake2b_t ctx;
+    CHECK_ZXERR(hash_blake2b_init(&ctx, HASH_SIZE, (const uint8_t *)ZCASH_SAPLING_OUTPUTS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
 
     uint8_t spends_hash[32] = {0};
     uint8_t converts_hash[32] = {0};
@@ -247,9 +240,10 @@ zxerr_t tx_hash_sapling_data(const parser_tx_t *txObj, uint8_t *output) {
     CHECK_ZXERR(tx_hash_transparent_outputs(txObj, converts_hash));
     CHECK_ZXERR(tx_hash_transparent_outputs(txObj, outputs_hash));
 
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, spends_hash, HASH_SIZE, NULL, 0));
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, converts_hash, HASH_SIZE, NULL, 0));
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, CX_LAST, outputs_hash, HASH_SIZE, output, HASH_SIZE));
+    CHECK_ZXERR(hash_blake2b_update(&ctx, spends_hash, HASH_SIZE));
+    CHECK_ZXERR(hash_blake2b_update(&ctx, converts_hash, HASH_SIZE));
+    CHECK_ZXERR(hash_blake2b_update(&ctx, outputs_hash, HASH_SIZE));
+    CHECK_ZXERR(hash_blake2b_final(&ctx, output));
 
     return zxerr_ok;
 }
@@ -259,8 +253,8 @@ zxerr_t tx_hash_transparent_data(const parser_tx_t *txObj, uint8_t *output) {
         return zxerr_no_data;
     }
 
-    cx_blake2b_t ctx = {0};
-    CHECK_CX_OK(cx_blake2b_init2_no_throw(&ctx, 256, NULL, 0, (uint8_t*)ZCASH_SAPLING_OUTPUTS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
+    hash_blake2b_t ctx;
+    CHECK_ZXERR(hash_blake2b_init(&ctx, HASH_SIZE, (const uint8_t *)ZCASH_SAPLING_OUTPUTS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE));
 
     uint8_t outputs_hash[32] = {0};
     uint8_t inputs_hash[32] = {0};
@@ -268,8 +262,9 @@ zxerr_t tx_hash_transparent_data(const parser_tx_t *txObj, uint8_t *output) {
     CHECK_ZXERR(tx_hash_transparent_inputs(txObj, inputs_hash));
     CHECK_ZXERR(tx_hash_transparent_outputs(txObj, outputs_hash));
 
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, 0, inputs_hash, HASH_SIZE, NULL, 0));
-    CHECK_CX_OK(cx_hash_no_throw(&ctx.header, CX_LAST, outputs_hash, HASH_SIZE, output, HASH_SIZE));
+    CHECK_ZXERR(hash_blake2b_update(&ctx, inputs_hash, HASH_SIZE));
+    CHECK_ZXERR(hash_blake2b_update(&ctx, outputs_hash, HASH_SIZE));
+    CHECK_ZXERR(hash_blake2b_final(&ctx, output));
 
     return zxerr_ok;
 }
@@ -0,0 +1,254 @@
+/*******************************************************************************
+*   (c) 2018 - 2024 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "tx_stream.h"
+#include "coin.h"
+#include "parser_impl_common.h"
+#include "zxmacros.h"
+
+static zxerr_t stream_write(const tx_stream_t *stream, const uint8_t *data, uint32_t dataLen) {
+    if (dataLen == 0) {
+        return zxerr_ok;
+    }
+    if (stream->write(data, dataLen) != dataLen) {
+        return zxerr_buffer_too_small;
+    }
+    return zxerr_ok;
+}
+
+// Called once the current pass-through field has been fully consumed
+static zxerr_t finish_field(tx_stream_t *stream) {
+    switch (stream->state) {
+        case stream_salt:
+            stream->fieldLen = 0;
+            stream->state = stream->discriminant == DISCRIMINANT_DATA ? stream_data_len : stream_commitment;
+            break;
+        case stream_body_copy:
+        case stream_commitment_hash:
+            // Data sections end with their body, the others carry a tag
+            stream->state = stream->discriminant == DISCRIMINANT_DATA ? stream_section_done : stream_has_tag;
+            break;
+        case stream_body_hash: {
+            uint8_t bodyHash[HASH_LEN] = {0};
+            CHECK_ZXERR(hash_sha256_final(&stream->body, bodyHash))
+            if (stream->discriminant == DISCRIMINANT_DATA) {
+                // The hash covers the whole section, as crypto_hashDataSection computes it
+                const uint32_t marker = DATA_SECTION_COMPACTED;
+                CHECK_ZXERR(stream_write(stream, (const uint8_t *)&marker, sizeof(marker)))
+                CHECK_ZXERR(stream_write(stream, bodyHash, sizeof(bodyHash)))
+                stream->state = stream_section_done;
+                break;
+            }
+            // Written as the Hash variant of the commitment
+            const uint8_t commitment = 0;
+            CHECK_ZXERR(stream_write(stream, &commitment, sizeof(commitment)))
+            CHECK_ZXERR(stream_write(stream, bodyHash, sizeof(bodyHash)))
+            stream->state = stream_has_tag;
+            break;
+        }
+        case stream_tag:
+            stream->state = stream_section_done;
+            break;
+        default:
+            return zxerr_unknown;
+    }
+    return zxerr_ok;
+}
+
+static zxerr_t start_body(tx_stream_t *stream, uint32_t bodyLen) {
+    const bool data = stream->discriminant == DISCRIMINANT_DATA;
+    if (data && bodyLen == DATA_SECTION_COMPACTED) {
+        return zxerr_encoding_failed;
+    }
+
+    stream->remaining = bodyLen;
+    if (bodyLen > TX_STREAM_INLINE_MAX && !stream->keepBody) {
+        // Data sections already hash their prefix, see tx_stream_update
+        if (!data) {
+            CHECK_ZXERR(hash_sha256_init(&stream->body))
+        }
+        stream->compacted |= (uint32_t)1 << stream->section;
+        stream->state = stream_body_hash;
+        return zxerr_ok;
+    }
+
+    if (!data) {
+        const uint8_t commitment = 1;
+        CHECK_ZXERR(stream_write(stream, &commitment, sizeof(commitment)))
+    }
+    CHECK_ZXERR(stream_write(stream, stream->field, sizeof(stream->field)))
+    stream->state = stream_body_copy;
+    return bodyLen == 0 ? finish_field(stream) : zxerr_ok;
+}
+
+static zxerr_t start_tag(tx_stream_t *stream, uint32_t tagLen) {
+    CHECK_ZXERR(stream_write(stream, stream->field, sizeof(stream->field)))
+    stream->remaining = tagLen;
+    stream->state = stream_tag;
+    return tagLen == 0 ? finish_field(stream) : zxerr_ok;
+}
+
+zxerr_t tx_stream_init(tx_stream_t *stream, tx_stream_write_t write) {
+    if (stream == NULL || write == NULL) {
+        return zxerr_no_data;
+    }
+    MEMZERO(stream, sizeof(*stream));
+    stream->write = write;
+    stream->state = stream_copy;
+    return zxerr_ok;
+}
+
+zxerr_t tx_stream_update(tx_stream_t *stream, const uint8_t *data, uint32_t dataLen, uint8_t flags) {
+    if (stream == NULL || stream->write == NULL || (data == NULL && dataLen > 0)) {
+        return zxerr_no_data;
+    }
+
+    const bool sectionStart = (flags & TX_STREAM_SECTION_START) != 0;
+    if ((flags & TX_STREAM_KEEP_BODY) != 0 && !sectionStart) {
+        return zxerr_encoding_failed;
+    }
+
+    if (sectionStart) {
+        // A section can only start where the previous one ended
+        if (dataLen == 0 || (stream->state != stream_copy && stream->state != stream_section_done)) {
+            return zxerr_encoding_failed;
+        }
+        if (stream->section >= TX_STREAM_MAX_SECTIONS) {
+            return zxerr_encoding_failed;
+        }
+        const bool committed = data[0] == DISCRIMINANT_CODE || data[0] == DISCRIMINANT_EXTRA_DATA;
+        CHECK_ZXERR(stream_write(stream, data, 1))
+        if (data[0] == DISCRIMINANT_DATA) {
+            // The section hash starts at the discriminant
+            CHECK_ZXERR(hash_sha256_init(&stream->body))
+            CHECK_ZXERR(hash_sha256_update(&stream->body, data, 1))
+        }
+        stream->state = committed || data[0] == DISCRIMINANT_DATA ? stream_salt : stream_copy;
+        stream->section++;
+        stream->remaining = SALT_LEN;
+        stream->discriminant = data[0];
+        stream->keepBody = (flags & TX_STREAM_KEEP_BODY) != 0;
+        stream->received++;
+        data++;
+        dataLen--;
+    }
+
+    while (dataLen > 0) {
+        uint32_t consumed = 1;
+        switch (stream->state) {
+            case stream_copy:
+                consumed = dataLen;
+                CHECK_ZXERR(stream_write(stream, data, consumed))
+                break;
+
+            case stream_salt:
+            case stream_body_copy:
+            case stream_commitment_hash:
+            case stream_tag:
+                consumed = dataLen < stream->remaining ? dataLen : stream->remaining;
+                CHECK_ZXERR(stream_write(stream, data, consumed))
+                if (stream->state == stream_salt && stream->discriminant == DISCRIMINANT_DATA) {
+                    CHECK_ZXERR(hash_sha256_update(&stream->body, data, consumed))
+                }
+                stream->remaining -= consumed;
+                if (stream->remaining == 0) {
+                    CHECK_ZXERR(finish_field(stream))
+                }
+                break;
+
+            case stream_body_hash:
+                consumed = dataLen < stream->remaining ? dataLen : stream->remaining;
+                CHECK_ZXERR(hash_sha256_update(&stream->body, data, consumed))
+                stream->remaining -= consumed;
+                if (stream->remaining == 0) {
+                    CHECK_ZXERR(finish_field(stream))
+                }
+                break;
+
+            case stream_commitment:
+                // Held back until the body length tells how the body is written
+                if (data[0] == 0) {
+                    CHECK_ZXERR(stream_write(stream, data, 1))
+                    stream->remaining = HASH_LEN;
+                    stream->state = stream_commitment_hash;
+                } else if (data[0] == 1) {
+                    stream->fieldLen = 0;
+                    stream->state = stream_body_len;
+                } else {
+                    return zxerr_encoding_failed;
+                }
+                break;
+
+            case stream_has_tag:
+                CHECK_ZXERR(stream_write(stream, data, 1))
+                if (data[0] == 0) {
+                    stream->state = stream_section_done;
+                } else if (data[0] == 1) {
+                    stream->fieldLen = 0;
+                    stream->state = stream_tag_len;
+                } else {
+                    return zxerr_encoding_failed;
+                }
+                break;
+
+            case stream_data_len:
+            case stream_body_len:
+            case stream_tag_len: {
+                stream->field[stream->fieldLen++] = data[0];
+                if (stream->fieldLen < sizeof(stream->field)) {
+                    break;
+                }
+                uint32_t fieldValue = 0;
+                MEMCPY(&fieldValue, stream->field, sizeof(fieldValue));
+                if (stream->state == stream_data_len) {
+                    CHECK_ZXERR(hash_sha256_update(&stream->body, stream->field, sizeof(stream->field)))
+                    CHECK_ZXERR(start_body(stream, fieldValue))
+                } else if (stream->state == stream_body_len) {
+                    CHECK_ZXERR(start_body(stream, fieldValue))
+                } else {
+                    CHECK_ZXERR(start_tag(stream, fieldValue))
+                }
+                break;
+            }
+
+            case stream_section_done:
+            default:
+                // Anything after the tag has to start a new section
+                return zxerr_encoding_failed;
+        }
+        stream->received += consumed;
+        data += consumed;
+        dataLen -= consumed;
+    }
+
+    return zxerr_ok;
+}
+
+zxerr_t tx_stream_final(const tx_stream_t *stream) {
+    if (stream == NULL) {
+        return zxerr_no_data;
+    }
+    if (stream->state != stream_copy && stream->state != stream_section_done) {
+        return zxerr_encoding_failed;
+    }
+    return zxerr_ok;
+}
+
+bool tx_stream_compacted(const tx_stream_t *stream, uint8_t sectionIdx) {
+    if (stream == NULL || sectionIdx > TX_STREAM_MAX_SECTIONS) {
+        return false;
+    }
+    return (stream->compacted & ((uint32_t)1 << sectionIdx)) != 0;
+}
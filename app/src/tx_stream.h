@@ -0,0 +1,101 @@
+/*******************************************************************************
+*   (c) 2018 - 2024 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "zxerror.h"
+#include "hashing.h"
+
+// Streamed upload of transactions that do not fit in the transaction buffer.
+//
+// Code and extra data sections only commit to the sha256 of their body. While the
+// transaction streams in, bodies longer than TX_STREAM_INLINE_MAX are hashed on the fly
+// and written out as hash commitments, so the buffer holds the header, the section
+// framing and the hashes. Section hashes do not change, and the compacted transaction
+// goes through the regular parser.
+//
+// Data sections commit to their whole body, so a long one is hashed on the fly into
+// its section hash and written as DATA_SECTION_COMPACTED followed by that hash. The
+// parser only accepts that form for streamed uploads, and only for transactions that
+// do not show their data. Every other section is written as is.
+//
+// The host marks the chunks that start a section, and the sections the review shows
+// (the memo, the data) to be kept inline whatever their length. A wrong mark only
+// changes the bytes the parser sees, and those are the ones that get reviewed and
+// signed. The stream records which sections it compacted, so tx_parse can reject a
+// memo that would only be shown as a hash.
+
+// Short bodies, like most memos, are kept so they can still be shown
+#define TX_STREAM_INLINE_MAX 512
+
+// Sections past this index are rejected, the parser accepts far fewer
+#define TX_STREAM_MAX_SECTIONS 31
+
+// Flags for tx_stream_update
+#define TX_STREAM_SECTION_START 0x01
+#define TX_STREAM_KEEP_BODY     0x02
+
+typedef uint32_t (*tx_stream_write_t)(const uint8_t *data, uint32_t dataLen);
+
+typedef enum {
+    stream_copy = 0,
+    stream_salt,
+    stream_commitment,
+    stream_data_len,
+    stream_body_len,
+    stream_body_copy,
+    stream_body_hash,
+    stream_commitment_hash,
+    stream_has_tag,
+    stream_tag_len,
+    stream_tag,
+    stream_section_done,
+} tx_stream_state_e;
+
+typedef struct {
+    tx_stream_write_t write;
+    tx_stream_state_e state;
+    uint32_t received;
+    // Bytes left in the current field
+    uint32_t remaining;
+    uint8_t field[sizeof(uint32_t)];
+    uint8_t fieldLen;
+    hash_sha256_t body;
+    bool keepBody;
+    uint8_t discriminant;
+    // Index of the current section, counted from 1 as the parser does
+    uint8_t section;
+    // Bit i is set when the body of section i was compacted
+    uint32_t compacted;
+} tx_stream_t;
+
+zxerr_t tx_stream_init(tx_stream_t *stream, tx_stream_write_t write);
+// TX_STREAM_SECTION_START marks data that begins a new section, TX_STREAM_KEEP_BODY keeps
+// the body of that section inline
+zxerr_t tx_stream_update(tx_stream_t *stream, const uint8_t *data, uint32_t dataLen, uint8_t flags);
+// Fails if the stream stops in the middle of a code, data or extra data section
+zxerr_t tx_stream_final(const tx_stream_t *stream);
+// True when the body of the section at sectionIdx (counted from 1) was compacted
+bool tx_stream_compacted(const tx_stream_t *stream, uint8_t sectionIdx);
+
+#ifdef __cplusplus
+}
+#endif
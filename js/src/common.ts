@@ -14,11 +14,14 @@
  *  limitations under the License.
  ******************************************************************************* */
 export const CHUNK_SIZE = 250
+// Largest payload that fits a short APDU; bigger chunks need extended length encoding
+export const MAX_SHORT_APDU_PAYLOAD = 255
 
 export const PAYLOAD_TYPE = {
   INIT: 0x00,
   ADD: 0x01,
   LAST: 0x02,
+  STATUS: 0x03,
 }
 
 export const P1_VALUES = {
@@ -33,6 +36,11 @@ export const P2_VALUES = {
 // noinspection JSUnusedGlobalSymbols
 export const SIGN_VALUES_P2 = {
   DEFAULT: 0x00,
+  // Streamed upload: STREAM on the init chunk, SECTION_START on the chunk that starts a section,
+  // with SECTION_KEEP to keep the section body inline
+  STREAM: 0x01,
+  SECTION_START: 0x01,
+  SECTION_KEEP: 0x02,
 }
 
 export const ERROR_CODE = {
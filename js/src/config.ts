@@ -25,6 +25,12 @@ export const INS = {
   GET_CONVERT_RAND: 0x06,
   SIGN_MASP: 0x07,
   EXTRACT_SPEND_SIGN: 0x08,
+  GET_CAPABILITIES: 0x09,
+}
+export const FEATURES = {
+  SIGN_MASP: 0x01,
+  UPLOAD_RESUME: 0x02,
+  STREAMED_UPLOAD: 0x04,
 }
 export const SALT_LEN = 8
 export const HASH_LEN = 32
@@ -20,17 +20,29 @@ import {
   ResponseAddress,
   ResponseAppInfo,
   ResponseBase,
+  ResponseCapabilities,
   ResponseGetConvertRandomness,
   ResponseGetOutputRandomness,
   ResponseGetSpendRandomness,
   ResponseSign,
   ResponseSignMasp,
   ResponseVersion,
+  TransactionCounts,
 } from './types'
 
-import { CHUNK_SIZE, errorCodeToString, LedgerError, P1_VALUES, PAYLOAD_TYPE, processErrorResponse, serializePath } from './common'
-
-import { CLA, INS } from './config'
+import {
+  CHUNK_SIZE,
+  errorCodeToString,
+  LedgerError,
+  MAX_SHORT_APDU_PAYLOAD,
+  P1_VALUES,
+  PAYLOAD_TYPE,
+  processErrorResponse,
+  serializePath,
+  SIGN_VALUES_P2,
+} from './common'
+
+import { CLA, FEATURES, INS } from './config'
 import {
   getSignatureResponse,
   processConvertRandomnessResponse,
@@ -45,8 +57,13 @@ import {
 export { LedgerError }
 export * from './types'
 
+const MAX_UPLOAD_RETRIES = 3
+const SIGN_ACCEPTED_STATUS = [LedgerError.NoErrors, LedgerError.DataIsInvalid, LedgerError.BadKeyHandle, LedgerError.SignVerifyError]
+
 export class NamadaApp {
   transport: Transport
+  // null once the device answered that it does not support INS_GET_CAPABILITIES
+  private capabilities?: ResponseCapabilities | null
 
   constructor(transport: Transport) {
     if (!transport) {
@@ -56,21 +73,104 @@ export class NamadaApp {
     this.transport = transport
   }
 
-  async prepareChunks(serializedPath: Buffer, message: Buffer) {
+  async prepareChunks(serializedPath: Buffer, message: Buffer, chunkSize: number = CHUNK_SIZE) {
     const chunks = []
 
     chunks.push(serializedPath)
-    for (let i = 0; i < message.length; i += CHUNK_SIZE) {
-      let end = i + CHUNK_SIZE
-      if (i > message.length) {
-        end = message.length
-      }
-      chunks.push(message.subarray(i, end))
+    for (let i = 0; i < message.length; i += chunkSize) {
+      chunks.push(message.subarray(i, Math.min(i + chunkSize, message.length)))
     }
 
     return chunks
   }
 
+  async getCapabilities(): Promise<ResponseCapabilities> {
+    return this.transport.send(CLA, INS.GET_CAPABILITIES, 0, 0).then((response: Buffer) => {
+      const errorCodeData = response.subarray(-2)
+      const returnCode = errorCodeData[0] * 256 + errorCodeData[1]
+
+      const capabilities: ResponseCapabilities = {
+        returnCode,
+        errorMessage: errorCodeToString(returnCode),
+        maxChunkSize: response.readUInt16BE(0),
+        extendedApdu: response[2] === 1,
+      }
+
+      if (response.length >= 13) {
+        capabilities.txBufferSize = response.readUInt32BE(3)
+        capabilities.maxExtraDataSections = response[7]
+        capabilities.maxSignatureSections = response[8]
+        capabilities.maxMaspItems = response[9]
+        capabilities.features = response[10]
+      }
+
+      return capabilities
+    }, processErrorResponse)
+  }
+
+  // Capabilities are queried once per session
+  async getCachedCapabilities(): Promise<ResponseCapabilities | undefined> {
+    if (this.capabilities === undefined) {
+      const capabilities = await this.getCapabilities()
+      this.capabilities = capabilities.returnCode === LedgerError.NoErrors ? capabilities : null
+    }
+    return this.capabilities ?? undefined
+  }
+
+  // Chunk size used for INS_SIGN/INS_SIGN_MASP. Apps that predate INS_GET_CAPABILITIES keep the legacy CHUNK_SIZE.
+  async getChunkSize(): Promise<number> {
+    const capabilities = await this.getCachedCapabilities()
+    if (capabilities === undefined || capabilities.maxChunkSize === 0) {
+      return CHUNK_SIZE
+    }
+    return capabilities.extendedApdu ? capabilities.maxChunkSize : Math.min(capabilities.maxChunkSize, MAX_SHORT_APDU_PAYLOAD)
+  }
+
+  // Checks a transaction against the limits reported by the device, so that it can be rejected before uploading it.
+  // Returns undefined when the transaction fits or the device does not report its limits. A streamed transaction
+  // only has to fit once compacted, which the device checks as it goes.
+  async validateTransaction(length: number, counts: TransactionCounts = {}, streamed = false): Promise<ResponseBase | undefined> {
+    const capabilities = await this.getCachedCapabilities()
+    if (capabilities?.txBufferSize === undefined) {
+      return undefined
+    }
+
+    const skipSize = streamed && ((capabilities.features ?? 0) & FEATURES.STREAMED_UPLOAD) !== 0
+    const checks: [string, number | undefined, number | undefined][] = [
+      ['transaction size', skipSize ? undefined : length, capabilities.txBufferSize],
+      ['extra data sections', counts.extraDataSections, capabilities.maxExtraDataSections],
+      ['signature sections', counts.signatureSections, capabilities.maxSignatureSections],
+      ['spends', counts.spends, capabilities.maxMaspItems],
+      ['outputs', counts.outputs, capabilities.maxMaspItems],
+      ['converts', counts.converts, capabilities.maxMaspItems],
+    ]
+
+    for (const [name, value, limit] of checks) {
+      if (value !== undefined && limit !== undefined && value > limit) {
+        return {
+          returnCode: LedgerError.DataIsInvalid,
+          errorMessage: `${errorCodeToString(LedgerError.DataIsInvalid)} : ${name} ${value} exceeds device limit ${limit}`,
+        }
+      }
+    }
+    return undefined
+  }
+
+  // Sends a chunk as a short APDU when it fits, otherwise with extended length encoding
+  async sendChunkApdu(ins: number, p1: number, p2: number, chunk: Buffer, statusList: number[]): Promise<Buffer> {
+    if (chunk.length <= MAX_SHORT_APDU_PAYLOAD) {
+      return this.transport.send(CLA, ins, p1, p2, chunk, statusList)
+    }
+
+    const header = Buffer.from([CLA, ins, p1, p2, 0x00, (chunk.length >> 8) & 0xff, chunk.length & 0xff])
+    const response = await this.transport.exchange(Buffer.concat([header, chunk]))
+    const statusCode = response.readUInt16BE(response.length - 2)
+    if (!statusList.includes(statusCode)) {
+      throw { statusCode }
+    }
+    return response
+  }
+
   async getVersion(): Promise<ResponseVersion> {
     return this.transport.send(CLA, INS.GET_VERSION, 0, 0).then((response: any) => {
       const errorCodeData = response.slice(-2)
@@ -160,9 +260,35 @@ export class NamadaApp {
       .then(processGetAddrResponse, processErrorResponse)
   }
 
+  // Parses the answer to an INS_SIGN / INS_SIGN_MASP chunk
+  processUploadResponse(ins: number, response: Buffer): ResponseBase {
+    const errorCodeData = response.subarray(-2)
+    const returnCode = errorCodeData[0] * 256 + errorCodeData[1]
+    let errorMessage = errorCodeToString(returnCode)
+
+    if (returnCode === LedgerError.BadKeyHandle || returnCode === LedgerError.DataIsInvalid || returnCode === LedgerError.SignVerifyError) {
+      errorMessage = `${errorMessage} : ${response.subarray(0, response.length - 2).toString('ascii')}`
+    }
+
+    if (returnCode === LedgerError.NoErrors && response.length > 2) {
+      if (ins === INS.SIGN_MASP) {
+        return processMaspSign(response)
+      }
+      return {
+        signature: getSignatureResponse(response),
+        returnCode,
+        errorMessage,
+      } as ResponseSign
+    }
+
+    return {
+      returnCode,
+      errorMessage,
+    }
+  }
+
   async signSendChunk(chunkIdx: number, chunkNum: number, chunk: Buffer, ins: number): Promise<ResponseBase> {
     let payloadType = PAYLOAD_TYPE.ADD
-    const p2 = 0
     if (chunkIdx === 1) {
       payloadType = PAYLOAD_TYPE.INIT
     }
@@ -170,101 +296,135 @@ export class NamadaApp {
       payloadType = PAYLOAD_TYPE.LAST
     }
 
-    return this.transport
-      .send(CLA, ins, payloadType, p2, chunk, [
-        LedgerError.NoErrors,
-        LedgerError.DataIsInvalid,
-        LedgerError.BadKeyHandle,
-        LedgerError.SignVerifyError,
-      ])
-      .then((response: Buffer) => {
-        const errorCodeData = response.subarray(-2)
-        const returnCode = errorCodeData[0] * 256 + errorCodeData[1]
-        let errorMessage = errorCodeToString(returnCode)
-
-        if (
-          returnCode === LedgerError.BadKeyHandle ||
-          returnCode === LedgerError.DataIsInvalid ||
-          returnCode === LedgerError.SignVerifyError
-        ) {
-          errorMessage = `${errorMessage} : ${response.subarray(0, response.length - 2).toString('ascii')}`
-        }
+    return this.sendChunkApdu(ins, payloadType, 0, chunk, SIGN_ACCEPTED_STATUS).then(
+      response => this.processUploadResponse(ins, response),
+      processErrorResponse,
+    )
+  }
 
-        if (returnCode === LedgerError.NoErrors && response.length > 2) {
-          return {
-            signature: getSignatureResponse(response),
-            returnCode,
-            errorMessage,
-          }
-        }
+  async signSendMaspChunk(chunkIdx: number, chunkNum: number, chunk: Buffer, ins: number): Promise<ResponseBase> {
+    return this.signSendChunk(chunkIdx, chunkNum, chunk, ins)
+  }
 
-        return {
-          returnCode: returnCode,
-          errorMessage: errorMessage,
-        } as ResponseSign
-      }, processErrorResponse)
+  // Number of bytes received so far by the upload in progress for `ins`, or undefined if there is none
+  async getUploadStatus(ins: number): Promise<number | undefined> {
+    return this.transport.send(CLA, ins, PAYLOAD_TYPE.STATUS, 0, Buffer.from([])).then(
+      response => (response.length >= 6 ? response.readUInt32BE(0) : undefined),
+      () => undefined,
+    )
   }
 
-  async signSendMaspChunk(chunkIdx: number, chunkNum: number, chunk: Buffer, ins: number): Promise<ResponseBase> {
-    let payloadType = PAYLOAD_TYPE.ADD
-    const p2 = 0
-    if (chunkIdx === 1) {
-      payloadType = PAYLOAD_TYPE.INIT
+  // Uploads `message` for INS_SIGN / INS_SIGN_MASP. When a chunk is lost to a transport error
+  // the device is asked how many bytes it received and the upload resumes from that offset.
+  async uploadChunks(ins: number, serializedPath: Buffer, message: Buffer, counts?: TransactionCounts): Promise<ResponseBase> {
+    return this.uploadSegments(ins, serializedPath, [{ data: message, p2: SIGN_VALUES_P2.DEFAULT }], counts)
+  }
+
+  // Same as uploadChunks for a message given as segments, each with the P2 of its first chunk. Chunks never
+  // cross a segment boundary, so a streamed upload (initP2 = STREAM) can mark where sections start.
+  async uploadSegments(
+    ins: number,
+    serializedPath: Buffer,
+    segments: { data: Buffer; p2: number }[],
+    counts?: TransactionCounts,
+    initP2: number = SIGN_VALUES_P2.DEFAULT,
+  ): Promise<ResponseBase> {
+    const message = Buffer.concat(segments.map(segment => segment.data))
+    if (message.length === 0) {
+      return { returnCode: LedgerError.EmptyBuffer, errorMessage: errorCodeToString(LedgerError.EmptyBuffer) }
     }
-    if (chunkIdx === chunkNum) {
-      payloadType = PAYLOAD_TYPE.LAST
+
+    const streamed = (initP2 & SIGN_VALUES_P2.STREAM) !== 0
+    const invalid = await this.validateTransaction(message.length, counts, streamed)
+    if (invalid !== undefined) {
+      return invalid
     }
 
-    return this.transport
-      .send(CLA, ins, payloadType, p2, chunk, [
-        LedgerError.NoErrors,
-        LedgerError.DataIsInvalid,
-        LedgerError.BadKeyHandle,
-        LedgerError.SignVerifyError,
-      ])
-      .then((response: Buffer) => {
-        const errorCodeData = response.subarray(-2)
-        const returnCode = errorCodeData[0] * 256 + errorCodeData[1]
-        let errorMessage = errorCodeToString(returnCode)
-
-        if (
-          returnCode === LedgerError.BadKeyHandle ||
-          returnCode === LedgerError.DataIsInvalid ||
-          returnCode === LedgerError.SignVerifyError
-        ) {
-          errorMessage = `${errorMessage} : ${response.subarray(0, response.length - 2).toString('ascii')}`
-        }
+    // Offset and P2 of the first chunk of every segment
+    const starts: [number, number][] = []
+    let start = 0
+    for (const segment of segments.filter(segment => segment.data.length > 0)) {
+      starts.push([start, segment.p2])
+      start += segment.data.length
+    }
+
+    const chunkSize = await this.getChunkSize()
+    let retries = 0
+    let response = Buffer.alloc(0)
+    let offset = -1
+
+    for (;;) {
+      let payloadType = PAYLOAD_TYPE.INIT
+      let p2 = initP2
+      let chunk = serializedPath
+      if (offset >= 0) {
+        const segment = starts.findIndex(([segmentStart]) => segmentStart > offset)
+        const segmentIdx = (segment < 0 ? starts.length : segment) - 1
+        const segmentEnd = segment < 0 ? message.length : starts[segment][0]
+        const end = Math.min(offset + chunkSize, segmentEnd)
+        payloadType = end === message.length ? PAYLOAD_TYPE.LAST : PAYLOAD_TYPE.ADD
+        p2 = starts[segmentIdx][0] === offset ? starts[segmentIdx][1] : SIGN_VALUES_P2.DEFAULT
+        chunk = message.subarray(offset, end)
+      }
 
-        if (returnCode === LedgerError.NoErrors && response.length > 2) {
-          return processMaspSign(response);
+      try {
+        response = await this.sendChunkApdu(ins, payloadType, p2, chunk, SIGN_ACCEPTED_STATUS)
+      } catch (e: any) {
+        // Status words are answers from the app, only transport errors are worth resuming
+        if (e?.statusCode !== undefined || payloadType === PAYLOAD_TYPE.INIT || retries >= MAX_UPLOAD_RETRIES) {
+          return processErrorResponse(e)
         }
+        const received = await this.getUploadStatus(ins)
+        if (received === undefined || received > message.length) {
+          return processErrorResponse(e)
+        }
+        retries += 1
+        offset = received
+        continue
+      }
 
-        return {
-          returnCode: returnCode,
-          errorMessage: errorMessage,
-        } as ResponseSignMasp
-      }, processErrorResponse)
+      if (response.readUInt16BE(response.length - 2) !== LedgerError.NoErrors || payloadType === PAYLOAD_TYPE.LAST) {
+        break
+      }
+      offset = offset < 0 ? 0 : offset + chunk.length
+    }
+
+    return this.processUploadResponse(ins, response)
   }
 
-  async sign(path: string, message: Buffer): Promise<ResponseSign> {
+  async sign(path: string, message: Buffer, counts?: TransactionCounts): Promise<ResponseSign> {
     const serializedPath = serializePath(path)
+    return this.uploadChunks(INS.SIGN, serializedPath, message, counts)
+  }
 
-    return this.prepareChunks(serializedPath, message).then(chunks => {
-      return this.signSendChunk(1, chunks.length, chunks[0], INS.SIGN).then(async response => {
-        let result: ResponseSign = {
-          returnCode: response.returnCode,
-          errorMessage: response.errorMessage,
-        }
+  // Signs a transaction too large for the device buffer with a streamed upload. `header` holds the bytes up to
+  // and including the section count, `sections` the serialized sections. `keepSections` holds the indexes of the
+  // sections the review shows, which are kept inline: the extra data section the header memo hash points to, which
+  // the device rejects otherwise, and the data section of any transaction that is not custom.
+  async signStreamed(
+    path: string,
+    header: Buffer,
+    sections: Buffer[],
+    keepSections: number[] = [],
+    counts?: TransactionCounts,
+  ): Promise<ResponseSign> {
+    const capabilities = await this.getCachedCapabilities()
+    if (((capabilities?.features ?? 0) & FEATURES.STREAMED_UPLOAD) === 0) {
+      return {
+        returnCode: LedgerError.DataIsInvalid,
+        errorMessage: `${errorCodeToString(LedgerError.DataIsInvalid)} : streamed upload not supported by the device`,
+      }
+    }
 
-        for (let i = 1; i < chunks.length; i++) {
-          result = await this.signSendChunk(1 + i, chunks.length, chunks[i], INS.SIGN)
-          if (result.returnCode !== LedgerError.NoErrors) {
-            break
-          }
-        }
-        return result
-      }, processErrorResponse)
-    }, processErrorResponse)
+    const serializedPath = serializePath(path)
+    const segments = [
+      { data: header, p2: SIGN_VALUES_P2.DEFAULT },
+      ...sections.map((data, idx) => ({
+        data,
+        p2: keepSections.includes(idx) ? SIGN_VALUES_P2.SECTION_START | SIGN_VALUES_P2.SECTION_KEEP : SIGN_VALUES_P2.SECTION_START,
+      })),
+    ]
+    return this.uploadSegments(INS.SIGN, serializedPath, segments, counts, SIGN_VALUES_P2.STREAM)
   }
 
   async retrieveKeys(path: string, keyType: NamadaKeys, showInDevice: boolean): Promise<KeyResponse> {
@@ -275,24 +435,9 @@ export class NamadaApp {
       .then(result => processGetKeysResponse(result, keyType) as KeyResponse, processErrorResponse)
   }
 
-  async signMasp(path: string, masp: Buffer): Promise<ResponseSignMasp> {
+  async signMasp(path: string, masp: Buffer, counts?: TransactionCounts): Promise<ResponseSignMasp> {
     const serializedPath = serializePath(path)
-    return this.prepareChunks(serializedPath, masp).then(chunks => {
-      return this.signSendMaspChunk(1, chunks.length, chunks[0], INS.SIGN_MASP).then(async response => {
-        let result: ResponseSign = {
-          returnCode: response.returnCode,
-          errorMessage: response.errorMessage,
-        }
-
-        for (let i = 1; i < chunks.length; i++) {
-          result = await this.signSendMaspChunk(1 + i, chunks.length, chunks[i], INS.SIGN_MASP)
-          if (result.returnCode !== LedgerError.NoErrors) {
-            break
-          }
-        }
-        return result
-      }, processErrorResponse)
-    }, processErrorResponse)
+    return this.uploadChunks(INS.SIGN_MASP, serializedPath, masp, counts) as Promise<ResponseSignMasp>
   }
 
   async getSpendRandomness(): Promise<ResponseGetSpendRandomness> {
@@ -0,0 +1,130 @@
+/** ******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************* */
+
+// Default key/value sizes match the ones used by the device review screens
+const DEFAULT_KEY_LEN = 40
+const DEFAULT_VALUE_LEN = 40
+const PARSER_OK = 0
+
+// Second element of the derivation path, it selects the address HRPs shown by the device
+export const COIN_TYPE = {
+  MAINNET: 877,
+  TESTNET: 1,
+}
+
+export interface ParserItem {
+  displayIdx: number
+  key: string
+  value: string
+  pageIdx: number
+  pageCount: number
+}
+
+export class ParserError extends Error {
+  code: number
+
+  constructor(code: number, description: string) {
+    super(description)
+    this.code = code
+  }
+}
+
+/**
+ * Host-side version of the app transaction parser, compiled to WebAssembly.
+ * It produces exactly the items the device would show during review.
+ */
+export class NamadaParser {
+  private module: any
+
+  private constructor(module: any) {
+    this.module = module
+  }
+
+  // Instantiates the module built with `emcmake cmake -DENABLE_WASM=ON`
+  static async load(): Promise<NamadaParser> {
+    const createNamadaParser = require('../wasm/namada_parser.js')
+    return new NamadaParser(await createNamadaParser())
+  }
+
+  private check(err: number) {
+    if (err !== PARSER_OK) {
+      throw new ParserError(err, this.module.UTF8ToString(this.module._wasm_parser_getErrorDescription(err)))
+    }
+  }
+
+  // Parses and validates a serialized transaction, as done by the device after the last chunk. `coinType` is the
+  // one of the path the transaction will be signed with.
+  parse(blob: Buffer, expertMode = false, coinType = COIN_TYPE.MAINNET) {
+    const ptr = this.module._malloc(blob.length)
+    try {
+      this.module.HEAPU8.set(blob, ptr)
+      this.check(this.module._wasm_parser_parse(ptr, blob.length, expertMode ? 1 : 0, coinType))
+    } finally {
+      this.module._free(ptr)
+    }
+  }
+
+  getNumItems(): number {
+    const ptr = this.module._malloc(1)
+    try {
+      this.check(this.module._wasm_parser_getNumItems(ptr))
+      return this.module.HEAPU8[ptr]
+    } finally {
+      this.module._free(ptr)
+    }
+  }
+
+  getItem(displayIdx: number, pageIdx: number, keyLen = DEFAULT_KEY_LEN, valueLen = DEFAULT_VALUE_LEN): ParserItem {
+    const keyPtr = this.module._malloc(keyLen)
+    const valuePtr = this.module._malloc(valueLen)
+    const pageCountPtr = this.module._malloc(1)
+    try {
+      this.check(this.module._wasm_parser_getItem(displayIdx, keyPtr, keyLen, valuePtr, valueLen, pageIdx, pageCountPtr))
+      return {
+        displayIdx,
+        key: this.module.UTF8ToString(keyPtr),
+        value: this.module.UTF8ToString(valuePtr),
+        pageIdx,
+        pageCount: this.module.HEAPU8[pageCountPtr],
+      }
+    } finally {
+      this.module._free(keyPtr)
+      this.module._free(valuePtr)
+      this.module._free(pageCountPtr)
+    }
+  }
+
+  // Returns every page of every item, in display order
+  getAllItems(keyLen = DEFAULT_KEY_LEN, valueLen = DEFAULT_VALUE_LEN): ParserItem[] {
+    const items: ParserItem[] = []
+    const numItems = this.getNumItems()
+    for (let displayIdx = 0; displayIdx < numItems; displayIdx++) {
+      let pageCount = 1
+      for (let pageIdx = 0; pageIdx < pageCount; pageIdx++) {
+        const item = this.getItem(displayIdx, pageIdx, keyLen, valueLen)
+        pageCount = item.pageCount
+        items.push(item)
+      }
+    }
+    return items
+  }
+}
+
+// Formats items the same way as the `output` fields of tests/testvectors.json
+export function formatItem(item: ParserItem): string {
+  const page = item.pageCount > 1 ? ` [${item.pageIdx + 1}/${item.pageCount}]` : ''
+  return `${item.displayIdx} | ${item.key}${page} : ${item.value}`
+}
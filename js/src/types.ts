@@ -22,6 +22,26 @@ export interface ResponseVersion extends ResponseBase {
   targetId: string
 }
 
+export interface ResponseCapabilities extends ResponseBase {
+  maxChunkSize: number
+  extendedApdu: boolean
+  // Transaction limits, not reported by older app versions
+  txBufferSize?: number
+  maxExtraDataSections?: number
+  maxSignatureSections?: number
+  maxMaspItems?: number
+  features?: number
+}
+
+// Section counts of a transaction, checked against the limits reported by the device
+export interface TransactionCounts {
+  extraDataSections?: number
+  signatureSections?: number
+  spends?: number
+  outputs?: number
+  converts?: number
+}
+
 export interface ResponseAppInfo extends ResponseBase {
   appName: string
   appVersion: string
@@ -0,0 +1,52 @@
+/** ******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************* */
+const { test } = require('node:test')
+const assert = require('node:assert')
+const path = require('node:path')
+
+const { COIN_TYPE, NamadaParser, formatItem } = require('../dist/parserWasm')
+const testvectors = require(path.join(__dirname, '../../tests/testvectors.json'))
+// Same transactions shown for a testnet path
+const testnetVectors = require(path.join(__dirname, 'testvectors_testnet.json'))
+
+// Same key/value sizes used by tests/common.cpp
+const KEY_LEN = 39
+const VALUE_LEN = 39
+
+for (const tc of testvectors) {
+  for (const expertMode of [false, true]) {
+    test(`${tc.index}_${tc.name} ${expertMode ? 'expert' : 'normal'}`, async () => {
+      const parser = await NamadaParser.load()
+      parser.parse(Buffer.from(tc.blob, 'hex'), expertMode)
+
+      const output = parser.getAllItems(KEY_LEN, VALUE_LEN).map(formatItem)
+      assert.deepStrictEqual(output, expertMode ? tc.output_expert : tc.output)
+    })
+  }
+}
+
+for (const tc of testnetVectors) {
+  const { blob } = testvectors.find(vector => vector.name === tc.name)
+  for (const expertMode of [false, true]) {
+    test(`${tc.index}_${tc.name} testnet ${expertMode ? 'expert' : 'normal'}`, async () => {
+      const parser = await NamadaParser.load()
+      parser.parse(Buffer.from(blob, 'hex'), expertMode, COIN_TYPE.TESTNET)
+
+      const output = parser.getAllItems(KEY_LEN, VALUE_LEN).map(formatItem)
+      assert.deepStrictEqual(output, expertMode ? tc.output_expert : tc.output)
+    })
+  }
+}
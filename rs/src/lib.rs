@@ -21,20 +21,25 @@
 #![doc(html_root_url = "https://docs.rs/ledger-namada/0.0.2")]
 
 use ed25519_dalek::Verifier;
-use ledger_transport::{APDUCommand, APDUErrorCode, Exchange};
+use ledger_transport::{APDUAnswer, APDUCommand, APDUErrorCode, Exchange};
 use ledger_zondax_generic::{App, AppExt, ChunkPayloadType, Version};
 
 use sha2::{Digest, Sha256};
 use std::collections::HashMap;
+use std::sync::Mutex;
 
 pub use ledger_zondax_generic::LedgerAppError;
 
 mod params;
-use params::SALT_LEN;
 pub use params::{
     InstructionCode, ADDRESS_LEN, CLA, ED25519_PUBKEY_LEN, PK_LEN_PLUS_TAG, SIG_LEN_PLUS_TAG,
 };
+use params::{
+    DEFAULT_CHUNK_SIZE, FEATURE_STREAMED_UPLOAD, MAX_SHORT_APDU_PAYLOAD, MAX_UPLOAD_RETRIES,
+    SALT_LEN, SECTION_KEEP_P2, SECTION_START_P2, STREAM_P2, UPLOAD_STATUS_P1,
+};
 use utils::{ResponseAddress, ResponseSignature};
+pub use utils::{ResponseCapabilities, TransactionCounts, TransactionLimits};
 
 use std::convert::TryInto;
 use std::str;
@@ -51,6 +56,9 @@ where
     #[error("Ledger | {0}")]
     /// Common Ledger errors
     Ledger(#[from] LedgerAppError<E>),
+    /// Transaction exceeds the limits reported by the app
+    #[error("Limit exceeded | {0}")]
+    LimitExceeded(String),
     // /// Device related errors
     // #[error("Secp256k1 error: {0}")]
     // Secp256k1(#[from] k256::elliptic_curve::Error),
@@ -63,6 +71,8 @@ where
 /// Namada App
 pub struct NamadaApp<E> {
     apdu_transport: E,
+    // Queried once per session, `Some(None)` when the app does not report them
+    capabilities: Mutex<Option<Option<ResponseCapabilities>>>,
 }
 
 impl<E: Exchange> App for NamadaApp<E> {
@@ -74,6 +84,7 @@ impl<E> NamadaApp<E> {
     pub const fn new(transport: E) -> Self {
         NamadaApp {
             apdu_transport: transport,
+            capabilities: Mutex::new(None),
         }
     }
 }
@@ -90,6 +101,227 @@ where
             .map_err(Into::into)
     }
 
+    /// Retrieve the chunk sizes and transaction limits accepted by the app
+    pub async fn get_capabilities(&self) -> Result<ResponseCapabilities, NamError<E::Error>> {
+        let command = APDUCommand {
+            cla: CLA,
+            ins: InstructionCode::GetCapabilities as _,
+            p1: 0x00,
+            p2: 0x00,
+            data: Vec::<u8>::new(),
+        };
+
+        let response = self
+            .apdu_transport
+            .exchange(&command)
+            .await
+            .map_err(LedgerAppError::TransportError)?;
+
+        let response_data = response.data();
+        match response.error_code() {
+            Ok(APDUErrorCode::NoError) if response_data.len() < 3 => {
+                return Err(NamError::Ledger(LedgerAppError::AppSpecific(
+                    APDUErrorCode::DataInvalid as _,
+                    "Invalid capabilities response".to_string(),
+                )))
+            }
+            Ok(APDUErrorCode::NoError) => {}
+            Ok(err) => {
+                return Err(NamError::Ledger(LedgerAppError::AppSpecific(
+                    err as _,
+                    err.description(),
+                )))
+            }
+            Err(err) => {
+                return Err(NamError::Ledger(LedgerAppError::AppSpecific(
+                    err,
+                    "[APDU_ERROR] Unknown".to_string(),
+                )))
+            }
+        }
+
+        let limits = if response_data.len() >= 11 {
+            Some(TransactionLimits {
+                tx_buffer_size: u32::from_be_bytes(response_data[3..7].try_into().unwrap())
+                    as usize,
+                max_extra_data_sections: response_data[7] as usize,
+                max_signature_sections: response_data[8] as usize,
+                max_masp_items: response_data[9] as usize,
+                features: response_data[10],
+            })
+        } else {
+            None
+        };
+
+        Ok(ResponseCapabilities {
+            max_chunk_size: u16::from_be_bytes([response_data[0], response_data[1]]) as usize,
+            extended_apdu: response_data[2] == 1,
+            limits,
+        })
+    }
+
+    /// Capabilities of the app, queried on first use only
+    async fn cached_capabilities(&self) -> Option<ResponseCapabilities> {
+        let cached = self.capabilities.lock().ok()?.clone();
+        if let Some(capabilities) = cached {
+            return capabilities;
+        }
+
+        let capabilities = self.get_capabilities().await.ok();
+        if let Ok(mut cached) = self.capabilities.lock() {
+            *cached = Some(capabilities.clone());
+        }
+        capabilities
+    }
+
+    /// Check a transaction against the limits reported by the app, so that it
+    /// can be rejected before uploading it. Apps that do not report their
+    /// limits accept any transaction here.
+    pub async fn validate_transaction(
+        &self,
+        blob: &[u8],
+        counts: &TransactionCounts,
+    ) -> Result<(), NamError<E::Error>> {
+        match self.cached_capabilities().await {
+            Some(ResponseCapabilities {
+                limits: Some(limits),
+                ..
+            }) => limits
+                .validate(blob.len(), counts)
+                .map_err(NamError::LimitExceeded),
+            _ => Ok(()),
+        }
+    }
+
+    /// Number of bytes received by the upload in progress for `ins`, if any
+    pub async fn upload_status(&self, ins: u8) -> Option<usize> {
+        let command = APDUCommand {
+            cla: CLA,
+            ins,
+            p1: UPLOAD_STATUS_P1,
+            p2: 0x00,
+            data: Vec::<u8>::new(),
+        };
+
+        let response = self.apdu_transport.exchange(&command).await.ok()?;
+        let response_data = response.data();
+        match response.error_code() {
+            Ok(APDUErrorCode::NoError) if response_data.len() >= 4 => {
+                Some(u32::from_be_bytes(response_data[..4].try_into().ok()?) as usize)
+            }
+            _ => None,
+        }
+    }
+
+    /// Upload protocol shared by every chunked instruction: send the init
+    /// command followed by the message split in chunks of the size negotiated
+    /// with the app. Stops at the first chunk that is not accepted. If a chunk
+    /// is lost to a transport error, the upload resumes from the offset the
+    /// app reports instead of starting over.
+    ///
+    /// The message is given as segments with the P2 of their first chunk.
+    /// Chunks never cross a segment boundary, which is what a streamed upload
+    /// needs to mark the sections.
+    async fn send_chunks(
+        &self,
+        command: APDUCommand<Vec<u8>>,
+        segments: &[(&[u8], u8)],
+    ) -> Result<APDUAnswer<E::AnswerType>, NamError<E::Error>> {
+        let message = segments
+            .iter()
+            .fold(Vec::new(), |mut message, (segment, _)| {
+                message.extend_from_slice(segment);
+                message
+            });
+        if message.is_empty() {
+            return Err(NamError::Ledger(LedgerAppError::InvalidEmptyMessage));
+        }
+
+        let mut starts = Vec::with_capacity(segments.len());
+        let mut start = 0;
+        for (segment, p2) in segments.iter().filter(|(segment, _)| !segment.is_empty()) {
+            starts.push((start, *p2));
+            start += segment.len();
+        }
+
+        // Apps that do not implement the capabilities query keep the legacy
+        // chunk size. Extended APDUs are not supported by the transport, so
+        // chunks are capped to a short APDU.
+        let mut chunk_size = DEFAULT_CHUNK_SIZE;
+        if let Some(capabilities) = self.cached_capabilities().await {
+            if let Some(limits) = &capabilities.limits {
+                // A streamed upload only has to fit once compacted, the app
+                // checks that as it goes
+                let streamed =
+                    command.p2 & STREAM_P2 != 0 && limits.features & FEATURE_STREAMED_UPLOAD != 0;
+                let len = if streamed { 0 } else { message.len() };
+                limits
+                    .validate(len, &TransactionCounts::default())
+                    .map_err(NamError::LimitExceeded)?;
+            }
+            if capabilities.max_chunk_size > 0 {
+                chunk_size = capabilities.max_chunk_size.min(MAX_SHORT_APDU_PAYLOAD);
+            }
+        }
+
+        let mut response = self
+            .apdu_transport
+            .exchange(&command)
+            .await
+            .map_err(LedgerAppError::TransportError)?;
+
+        let mut offset = 0;
+        let mut retries = 0;
+        while matches!(response.error_code(), Ok(APDUErrorCode::NoError)) {
+            // Index of the segment holding `offset`
+            let segment = starts.partition_point(|(start, _)| *start <= offset) - 1;
+            let segment_end = starts
+                .get(segment + 1)
+                .map_or(message.len(), |(start, _)| *start);
+            let end = segment_end.min(offset + chunk_size);
+            let p1 = if end == message.len() {
+                ChunkPayloadType::Last as u8
+            } else {
+                ChunkPayloadType::Add as u8
+            };
+            let p2 = if starts[segment].0 == offset {
+                starts[segment].1
+            } else {
+                0x00
+            };
+
+            let chunk_command = APDUCommand {
+                cla: command.cla,
+                ins: command.ins,
+                p1,
+                p2,
+                data: message[offset..end].to_vec(),
+            };
+
+            match self.apdu_transport.exchange(&chunk_command).await {
+                Ok(answer) => {
+                    response = answer;
+                    if p1 == ChunkPayloadType::Last as u8 {
+                        break;
+                    }
+                    offset = end;
+                }
+                Err(err) => {
+                    if retries >= MAX_UPLOAD_RETRIES {
+                        return Err(LedgerAppError::TransportError(err).into());
+                    }
+                    match self.upload_status(command.ins).await {
+                        Some(received) if received <= message.len() => offset = received,
+                        _ => return Err(LedgerAppError::TransportError(err).into()),
+                    }
+                    retries += 1;
+                }
+            }
+        }
+
+        Ok(response)
+    }
+
     /// Retrieves the public key and address
     pub async fn get_address_and_pubkey(
         &self,
@@ -165,9 +397,63 @@ where
             data: first_chunk,
         };
 
-        let response =
-            <Self as AppExt<E>>::send_chunks(&self.apdu_transport, start_command, blob).await?;
+        let response = self.send_chunks(start_command, &[(blob, 0x00)]).await?;
+        Self::parse_signature(response)
+    }
+
+    /// Sign wrapper transaction with a streamed upload, for transactions that
+    /// do not fit in the transaction buffer of the app. `header` holds the
+    /// bytes up to and including the section count, `sections` the serialized
+    /// sections. `keep_sections` holds the indexes in `sections` the review
+    /// shows, which are kept inline: the extra data section the header memo
+    /// hash points to, which the app rejects otherwise, and the data section
+    /// of any transaction that is not custom.
+    pub async fn sign_streamed(
+        &self,
+        path: &BIP44Path,
+        header: &[u8],
+        sections: &[Vec<u8>],
+        keep_sections: &[usize],
+    ) -> Result<ResponseSignature, NamError<E::Error>> {
+        let supported = matches!(
+            self.cached_capabilities().await,
+            Some(ResponseCapabilities { limits: Some(limits), .. })
+                if limits.features & FEATURE_STREAMED_UPLOAD != 0
+        );
+        if !supported {
+            return Err(NamError::LimitExceeded(
+                "streamed upload not supported by the app".to_string(),
+            ));
+        }
+
+        let first_chunk = path.serialize_path().unwrap();
+
+        let start_command = APDUCommand {
+            cla: CLA,
+            ins: InstructionCode::Sign as _,
+            p1: ChunkPayloadType::Init as u8,
+            p2: STREAM_P2,
+            data: first_chunk,
+        };
+
+        let mut segments = vec![(header, 0x00)];
+        for (idx, section) in sections.iter().enumerate() {
+            let p2 = if keep_sections.contains(&idx) {
+                SECTION_START_P2 | SECTION_KEEP_P2
+            } else {
+                SECTION_START_P2
+            };
+            segments.push((section.as_slice(), p2));
+        }
+
+        let response = self.send_chunks(start_command, &segments).await?;
+        Self::parse_signature(response)
+    }
 
+    /// Parses the signatures returned once a transaction is signed
+    fn parse_signature(
+        response: APDUAnswer<E::AnswerType>,
+    ) -> Result<ResponseSignature, NamError<E::Error>> {
         match response.error_code() {
             Ok(APDUErrorCode::NoError) => {}
             Ok(err) => {
@@ -34,6 +34,22 @@ pub const SIG_LEN_PLUS_TAG: usize = ED25519_SIGNATURE_LEN + 1;
 pub const SALT_LEN: usize = 8;
 /// Hash Length
 // pub const HASH_LEN: usize = 32;
+/// Chunk size used when the app does not report its capabilities
+pub const DEFAULT_CHUNK_SIZE: usize = 250;
+/// Largest payload that can be carried by a short APDU
+pub const MAX_SHORT_APDU_PAYLOAD: usize = 255;
+/// Payload type used to query how many bytes of an upload were received
+pub const UPLOAD_STATUS_P1: u8 = 0x03;
+/// Times an upload is resumed after a transport error before giving up
+pub const MAX_UPLOAD_RETRIES: usize = 3;
+/// Feature bit reported by apps that accept streamed uploads
+pub const FEATURE_STREAMED_UPLOAD: u8 = 0x04;
+/// P2 of the init command that starts a streamed upload
+pub const STREAM_P2: u8 = 0x01;
+/// P2 of the chunk that starts a section in a streamed upload
+pub const SECTION_START_P2: u8 = 0x01;
+/// Set with SECTION_START_P2 to keep the body of the section inline
+pub const SECTION_KEEP_P2: u8 = 0x02;
 /// Available instructions to interact with the Ledger device
 #[repr(u8)]
 pub enum InstructionCode {
@@ -41,6 +57,8 @@ pub enum InstructionCode {
     GetAddressAndPubkey = 1,
     /// Instruction to sign a transaction
     Sign = 2,
+    /// Instruction to retrieve the chunk sizes accepted by the app
+    GetCapabilities = 9,
 
     /// Instruction to retrieve a signed section
     GetSignature = 0x0a,
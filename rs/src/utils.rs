@@ -41,6 +41,76 @@ pub struct ResponseSignature {
     pub wrapper_indices: Vec<u8>,
 }
 
+/// Chunk sizes and transaction limits accepted by the app for INS_SIGN / INS_SIGN_MASP
+#[derive(Clone)]
+pub struct ResponseCapabilities {
+    /// Largest chunk payload the app can receive
+    pub max_chunk_size: usize,
+    /// Whether chunks may be sent using extended APDUs
+    pub extended_apdu: bool,
+    /// Transaction limits, not reported by older app versions
+    pub limits: Option<TransactionLimits>,
+}
+
+/// Transaction limits enforced by the app
+#[derive(Clone)]
+pub struct TransactionLimits {
+    /// Largest transaction the app can buffer
+    pub tx_buffer_size: usize,
+    /// Maximum number of extra data sections
+    pub max_extra_data_sections: usize,
+    /// Maximum number of signature sections
+    pub max_signature_sections: usize,
+    /// Maximum number of spends, outputs or converts in a MASP transaction
+    pub max_masp_items: usize,
+    /// Optional features supported by the app
+    pub features: u8,
+}
+
+/// Section counts of a transaction, checked against [`TransactionLimits`]
+#[derive(Default)]
+pub struct TransactionCounts {
+    /// Number of extra data sections
+    pub extra_data_sections: usize,
+    /// Number of signature sections
+    pub signature_sections: usize,
+    /// Number of MASP spends
+    pub spends: usize,
+    /// Number of MASP outputs
+    pub outputs: usize,
+    /// Number of MASP converts
+    pub converts: usize,
+}
+
+impl TransactionLimits {
+    /// Check a transaction of `len` bytes against the limits
+    pub fn validate(&self, len: usize, counts: &TransactionCounts) -> Result<(), String> {
+        let checks = [
+            ("transaction size", len, self.tx_buffer_size),
+            (
+                "extra data sections",
+                counts.extra_data_sections,
+                self.max_extra_data_sections,
+            ),
+            (
+                "signature sections",
+                counts.signature_sections,
+                self.max_signature_sections,
+            ),
+            ("spends", counts.spends, self.max_masp_items),
+            ("outputs", counts.outputs, self.max_masp_items),
+            ("converts", counts.converts, self.max_masp_items),
+        ];
+
+        for (name, value, limit) in checks.iter() {
+            if value > limit {
+                return Err(format!("{} {} exceeds device limit {}", name, value, limit));
+            }
+        }
+        Ok(())
+    }
+}
+
 /// BIP44 Path
 pub struct BIP44Path {
     /// BIP44 path in string format ("m/44'/283'/0/0/0")
@@ -0,0 +1,167 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <zxformat.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "hashing.h"
+#include "parser_txdef.h"
+#include "signhash.h"
+#include "tx_hash.h"
+
+static std::string toHex(const uint8_t *data, size_t len) {
+    char buffer[2 * HASH_BLAKE2B_MAX_LEN + 1] = {0};
+    array_to_hexstr(buffer, sizeof(buffer), data, len);
+    return std::string(buffer);
+}
+
+TEST(Hashing, Sha256) {
+    const uint8_t input[] = {'a', 'b', 'c'};
+    uint8_t output[HASH_SHA256_LEN] = {0};
+
+    ASSERT_EQ(hash_sha256(input, sizeof(input), output), zxerr_ok);
+    EXPECT_EQ(toHex(output, sizeof(output)), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    // Split updates, including empty ones, must not change the digest
+    hash_sha256_t ctx;
+    ASSERT_EQ(hash_sha256_init(&ctx), zxerr_ok);
+    ASSERT_EQ(hash_sha256_update(&ctx, input, 1), zxerr_ok);
+    ASSERT_EQ(hash_sha256_update(&ctx, nullptr, 0), zxerr_ok);
+    ASSERT_EQ(hash_sha256_update(&ctx, input + 1, 2), zxerr_ok);
+    ASSERT_EQ(hash_sha256_final(&ctx, output), zxerr_ok);
+    EXPECT_EQ(toHex(output, sizeof(output)), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+TEST(Hashing, Blake2bPersonalized) {
+    const uint8_t input[] = {'a', 'b', 'c'};
+    uint8_t output[HASH_BLAKE2B_MAX_LEN] = {0};
+
+    hash_blake2b_t ctx;
+    ASSERT_EQ(hash_blake2b_init(&ctx, sizeof(output), (const uint8_t *)"MASP__ExpandSeed", 16), zxerr_ok);
+    ASSERT_EQ(hash_blake2b_update(&ctx, input, sizeof(input)), zxerr_ok);
+    ASSERT_EQ(hash_blake2b_final(&ctx, output), zxerr_ok);
+    EXPECT_EQ(toHex(output, sizeof(output)),
+              "99ffba7498c741b1f81cad564fdbd3d009f16505ab4822f2156cec72c077ae7d"
+              "2d68bdfa8b26ad4ae1a1c9348426a180dd2e98a3d387849c31d8caac421a5240");
+
+    ASSERT_EQ(hash_blake2b_init(&ctx, 0, nullptr, 0), zxerr_invalid_crypto_settings);
+    ASSERT_EQ(hash_blake2b_init(&ctx, HASH_BLAKE2B_MAX_LEN + 1, nullptr, 0), zxerr_invalid_crypto_settings);
+}
+
+// Chunk sizes straddle the staging buffer: small updates that get merged,
+// updates that force a flush, and updates larger than the buffer itself
+TEST(Hashing, StagedUpdatesMatchOneShot) {
+    uint8_t data[300] = {0};
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 7 + 3);
+    }
+    const size_t chunks[] = {1, 4, 4, 0, 32, 8, 21, 63, 64, 65, 1, 37};
+
+    hash_sha256_t sha256;
+    hash_blake2b_t blake2b;
+    ASSERT_EQ(hash_sha256_init(&sha256), zxerr_ok);
+    ASSERT_EQ(hash_blake2b_init(&blake2b, HASH_SIZE, (const uint8_t *)ZCASH_HEADERS_HASH_PERSONALIZATION, PERSONALIZATION_SIZE), zxerr_ok);
+
+    size_t offset = 0;
+    for (size_t chunk : chunks) {
+        ASSERT_EQ(hash_sha256_update(&sha256, data + offset, chunk), zxerr_ok);
+        ASSERT_EQ(hash_blake2b_update(&blake2b, data + offset, chunk), zxerr_ok);
+        offset += chunk;
+    }
+    ASSERT_EQ(offset, sizeof(data));
+
+    uint8_t output[HASH_SHA256_LEN] = {0};
+    ASSERT_EQ(hash_sha256_final(&sha256, output), zxerr_ok);
+    EXPECT_EQ(toHex(output, sizeof(output)), "04773f8726c81cafcfa1a09a82664b98b00d2021031a1715bca1154f2dad3472");
+    ASSERT_EQ(hash_blake2b_final(&blake2b, output), zxerr_ok);
+    EXPECT_EQ(toHex(output, sizeof(output)), "90b73b3c2416b1490e034f036a7615d0fdf7bd98038e3c877ff510475c0c5c4e");
+}
+
+// Lanes of very different lengths, fed interleaved in uneven chunks, so some
+// compressions run with masked lanes and the final blocks are partially filled
+TEST(Hashing, Blake2bLanes) {
+    static const size_t lengths[] = {0, 129, 1000, 3000};
+    static const char *const personalizations[] = {ZCASH_SAPLING_OUTPUTS_COMPACT_HASH_PERSONALIZATION,
+                                                   ZCASH_SAPLING_OUTPUTS_MEMOS_HASH_PERSONALIZATION,
+                                                   ZCASH_SAPLING_OUTPUTS_NONCOMPACT_HASH_PERSONALIZATION,
+                                                   ZCASH_HEADERS_HASH_PERSONALIZATION};
+    static const char *const expected[] = {
+        "9580efb8a0946caad43359fd2cf596a2d899e01bea14d2cbe916355c7caa72a6",
+        "80c267f43859b3e590b39bb945710ef150b66ab0822f99ca25bbc1ed7e1c990a",
+        "bc529c21ba65b1f18fa6dea7db48968783187e666d9dc6b089e0d1b84de55809",
+        "c16f791817646ab8301d80782dfc4e18945356887ef9921768616a71620a6bb1",
+    };
+    const size_t chunks[] = {1, 4, 32, 52, 128, 7, 200, 511, 513, 64};
+    const uint8_t count = HASH_LANES < 4 ? HASH_LANES : 4;
+
+    std::vector<std::vector<uint8_t>> data(count);
+    for (uint8_t lane = 0; lane < count; lane++) {
+        for (size_t i = 0; i < lengths[lane]; i++) {
+            data[lane].push_back((uint8_t)(i * (lane + 3) + lane));
+        }
+    }
+
+    struct ScalarReset {
+        ~ScalarReset() { hash_lanes_force_scalar = false; }
+    } scalarReset;
+
+    hash_blake2b_lanes_t lanes;
+    // Same answers from the dispatched compression and from the scalar fallback
+    for (const bool forceScalar : {false, true}) {
+        SCOPED_TRACE(forceScalar ? "scalar" : "dispatched");
+        hash_lanes_force_scalar = forceScalar;
+        ASSERT_EQ(hash_blake2b_lanes_init(&lanes, count, HASH_SIZE, personalizations, PERSONALIZATION_SIZE), zxerr_ok);
+
+        size_t offset[4] = {0};
+        for (size_t step = 0, pending = count; pending > 0; step++) {
+            pending = 0;
+            for (uint8_t lane = 0; lane < count; lane++) {
+                const size_t chunk = std::min(chunks[(step + lane) % 10], lengths[lane] - offset[lane]);
+                ASSERT_EQ(hash_blake2b_lanes_update(&lanes, lane, data[lane].data() + offset[lane], chunk), zxerr_ok);
+                offset[lane] += chunk;
+                pending += lengths[lane] - offset[lane];
+            }
+        }
+
+        uint8_t outputs[4 * HASH_SIZE] = {0};
+        ASSERT_EQ(hash_blake2b_lanes_final(&lanes, outputs), zxerr_ok);
+        for (uint8_t lane = 0; lane < count; lane++) {
+            EXPECT_EQ(toHex(outputs + lane * HASH_SIZE, HASH_SIZE), expected[lane]) << "lane " << (int)lane;
+        }
+    }
+
+    ASSERT_EQ(hash_blake2b_lanes_init(&lanes, HASH_LANES + 1, HASH_SIZE, personalizations, PERSONALIZATION_SIZE),
+              zxerr_invalid_crypto_settings);
+}
+
+TEST(Hashing, EmptyTransactionDigests) {
+    parser_tx_t tx;
+    memset(&tx, 0, sizeof(tx));
+    uint8_t output[HASH_SIZE] = {0};
+
+    ASSERT_EQ(tx_hash_header_data(&tx, output), zxerr_ok);
+    EXPECT_EQ(toHex(output, sizeof(output)), "df62cfac9b693cf3d181c1e518bcc520429a4bcd06c33d025a0e58492c8a02c5");
+
+    ASSERT_EQ(tx_hash_transparent_inputs(&tx, output), zxerr_ok);
+    EXPECT_EQ(toHex(output, sizeof(output)), "75e8a531c81abe9d6cc9600b823eed1b004d584be8d980316fdefa1e0fcc1f6b");
+
+    ASSERT_EQ(signature_hash(&tx, output), zxerr_ok);
+    EXPECT_EQ(toHex(output, sizeof(output)), "729018541fe9e49c1d95ee1d075d0453c40e1f48ffaa7c1783fba8501e052b78");
+}
@@ -106,6 +106,13 @@ TEST(Keys, AK_NK_IVK_NON_HARDENED) {
     const string nk_str = toHexString(keys.nk, sizeof(keys.nk));
     EXPECT_EQ(nk_str, tv_not_hardened.nk);
 
+    // ak and nk computed together must match
+    uint8_t joint_ak[32] = {0};
+    uint8_t joint_nk[32] = {0};
+    ASSERT_EQ(computeAkNk(keys.ask, keys.nsk, joint_ak, joint_nk), parser_ok);
+    EXPECT_EQ(toHexString(joint_ak, sizeof(joint_ak)), tv_not_hardened.ak);
+    EXPECT_EQ(toHexString(joint_nk, sizeof(joint_nk)), tv_not_hardened.nk);
+
     // compute ivk
     computeIVK(keys.ak, keys.nk, keys.ivk);
     const string ivk_str = toHexString(keys.ivk, 32);
@@ -114,9 +121,48 @@ TEST(Keys, AK_NK_IVK_NON_HARDENED) {
     // compute diversifier d0
     uint8_t di[11] = {0};
     uint8_t d_index[11] = {0};
-    computeDiversifier(keys.dk, d_index, di);
+    uint8_t g_d[GD_LENGTH] = {0};
+    computeDiversifier(keys.dk, d_index, di, g_d);
     const string d0_str = toHexString(di, 11);
     EXPECT_EQ(d0_str, tv_not_hardened.d0);
+
+    // Restarting the search at the reported index finds d0 right away
+    uint8_t found_index[DIVERSIFIER_LENGTH] = {0};
+    uint8_t restart_index[DIVERSIFIER_LENGTH] = {0};
+    uint8_t d_restart[DIVERSIFIER_LENGTH] = {0};
+    memset(d_index, 0, sizeof(d_index));
+    ASSERT_EQ(computeDiversifierWithIndex(keys.dk, d_index, di, g_d, found_index), parser_ok);
+    EXPECT_EQ(toHexString(di, DIVERSIFIER_LENGTH), tv_not_hardened.d0);
+    memcpy(restart_index, found_index, DIVERSIFIER_LENGTH);
+    ASSERT_EQ(computeDiversifierWithIndex(keys.dk, restart_index, d_restart, g_d, found_index), parser_ok);
+    EXPECT_EQ(toHexString(d_restart, DIVERSIFIER_LENGTH), tv_not_hardened.d0);
+    uint8_t single[DIVERSIFIER_LENGTH] = {0};
+    memcpy(restart_index, found_index, DIVERSIFIER_LENGTH);
+    ASSERT_EQ(get_diversifier_list(keys.dk, restart_index, single, DIVERSIFIER_LENGTH), parser_ok);
+    EXPECT_EQ(toHexString(single, DIVERSIFIER_LENGTH), tv_not_hardened.d0);
+    memset(d_index, 0, sizeof(d_index));
+    ASSERT_EQ(computeDiversifier(keys.dk, d_index, di, g_d), parser_ok);
+
+    // pkd from the prepared group hash matches the one derived from d
+    uint8_t pkd[KEY_LENGTH] = {0};
+    uint8_t pkd_from_gd[KEY_LENGTH] = {0};
+    computePkd(keys.ivk, di, pkd);
+    computePkdFromGd(keys.ivk, g_d, pkd_from_gd);
+    EXPECT_EQ(toHexString(pkd_from_gd, KEY_LENGTH), toHexString(pkd, KEY_LENGTH));
+
+    // Several addresses under the same ivk, more than one batch
+    constexpr uint8_t addresses = 5;
+    uint8_t diversifiers[addresses][DIVERSIFIER_LENGTH] = {0};
+    uint8_t g_d_list[addresses * GD_LENGTH] = {0};
+    uint8_t pkd_list[addresses * KEY_LENGTH] = {0};
+    for (uint8_t i = 0; i < addresses; i++) {
+        ASSERT_EQ(computeDiversifier(keys.dk, d_index, diversifiers[i], g_d_list + i * GD_LENGTH), parser_ok);
+    }
+    ASSERT_EQ(computePkdList(keys.ivk, g_d_list, addresses, pkd_list), parser_ok);
+    for (uint8_t i = 0; i < addresses; i++) {
+        ASSERT_EQ(computePkd(keys.ivk, diversifiers[i], pkd), parser_ok);
+        EXPECT_EQ(toHexString(pkd_list + i * KEY_LENGTH, KEY_LENGTH), toHexString(pkd, KEY_LENGTH));
+    }
   }
 
 TEST(Keys, ADDRESS_NON_HARDENED) {
@@ -164,3 +210,21 @@ TEST(Keys, COMPUTE_CV) {
     const string cv_str = toHexString(cv, sizeof(cv));
     EXPECT_EQ(cv_str, tv_not_hardened.cv);
 }
+
+TEST(Keys, DIVERSIFIER_HASH_MIDSTATE) {
+    // blake2s("MASP__gd", GH_FIRST_BLOCK || d) computed over the full input
+    const vector<pair<string, string>> testvectors = {
+        {"993f455b74159e49f9cf33", "1150f0c83150955a1548668833764778658abe2eb77911b9782f9eb8cda49191"},
+        {"0000000000000000000000", "c9c4d44adaf54ff5eda431cadd2e635d0fadcee1fa41d4046dbe9698314b819a"},
+        {"ffffffffffffffffffffff", "23cf870f2aa9a6597757a4b2df57a38c495c3c792d66090def3486ecc6254fe1"},
+    };
+
+    for (const auto &tv : testvectors) {
+        uint8_t d[DIVERSIFIER_LENGTH] = {0};
+        parseHexString(d, sizeof(d), tv.first.c_str());
+
+        uint8_t hash[KEY_LENGTH] = {0};
+        computeDiversifierHash(d, hash);
+        EXPECT_EQ(toHexString(hash, sizeof(hash)), tv.second);
+    }
+}
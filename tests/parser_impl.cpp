@@ -23,6 +23,8 @@
 #include "crypto_helper.h"
 #include "leb128.h"
 #include "bech32.h"
+#include "bech32_encoding.h"
+#include "parser_address.h"
 
 using namespace std;
 struct NamAddress {
@@ -39,6 +41,15 @@ struct LEB128Testcase {
 
 extern uint32_t hdPath[HDPATH_LEN_DEFAULT];
 
+// Tests that select another network put mainnet back, even when they stop early
+class DefaultNetwork : public ::testing::Test {
+protected:
+    void TearDown() override { hdPath[1] = HDPATH_1_DEFAULT; }
+};
+
+class AddressTestnet : public DefaultNetwork {};
+class AltAddressEncoding : public DefaultNetwork {};
+
 TEST(AddressMainnet, NamadaEncoding) {
     const vector<NamAddress> addresses = {
         {"00ef4f3e86bda2707e6556d884ee9b84dc638aa66f3e93ba95e1e192201d24df58", "tpknam1qrh5705xhk38qln92mvgfm5msnwx8z4xdulf8w54u8seygqayn04ssjm4fh", "tnam1qznvavtnr32sg6xdjszh6v6v977wx80zrqp92avx"},
@@ -80,7 +91,7 @@ TEST(AddressMainnet, NamadaEncoding) {
     }
 }
 
-TEST(AddressTestnet, NamadaEncoding) {
+TEST_F(AddressTestnet, NamadaEncoding) {
     const vector<NamAddress> addresses = {
         {"005816b3661e718d005eb439e762ed33b1d497deb01bbae4cc622e9858db20af62", "testtpknam1qpvpdvmxrecc6qz7ksu7wchdxwcaf977kqdm4exvvghfskxmyzhky7p9ru7", "testtnam1qrvfj5x38gattvnw467vz8vefnqmcxxv2cexrmwe"},
         {"002ed81476c5a379c86df357fc7924e59044dd57d722ab91d99accd145220c3ac5", "testtpknam1qqhds9rkck3hnjrd7dtlc7fyukgyfh2h6u32hywentxdz3fzpsav2aa6yax", "testtnam1qzu7l3lhk5gatgvhwgh64kw5rqgmde5xagnf03xv"},
@@ -121,6 +132,78 @@ TEST(AddressTestnet, NamadaEncoding) {
     }
 }
 
+TEST(Bech32, PrefixMatchesFullEncoding) {
+    const char *hrps[] = {"tnam", "tpknam", "znam", "zvknam", "testtnam", "testtpknam", "testznam", "testzvknam"};
+    uint8_t data[ADDRESS_LEN_BYTES] = {0};
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 37 + 11);
+    }
+
+    for (const char *hrp : hrps) {
+        bech32_prefix_t prefix;
+        ASSERT_EQ(bech32PrefixInit(&prefix, hrp), zxerr_ok);
+
+        char expected[100] = {0};
+        char encoded[100] = {0};
+        ASSERT_EQ(bech32EncodeFromBytes(expected, sizeof(expected), hrp, data, sizeof(data), 1, BECH32_ENCODING_BECH32M), zxerr_ok);
+        ASSERT_EQ(bech32EncodeWithPrefix(encoded, sizeof(encoded), &prefix, data, sizeof(data), 1, BECH32_ENCODING_BECH32M), zxerr_ok);
+        EXPECT_STREQ(encoded, expected) << hrp;
+    }
+
+    bech32_prefix_t prefix;
+    EXPECT_EQ(bech32PrefixInit(&prefix, "Tnam"), zxerr_encoding_failed);
+}
+
+TEST_F(AltAddressEncoding, InternalAddresses) {
+    // Prefix of each internal tag, 0xFF for the ones with a payload
+    const uint8_t prefixes[] = {PREFIX_POS, PREFIX_SLASH_POOL, PREFIX_PARAMETERS, PREFIX_IBC, 0xFF, PREFIX_GOVERNANCE,
+                                PREFIX_ETH_BRIDGE, PREFIX_BRIDGE_POOL, 0xFF, 0xFF, PREFIX_MULTITOKEN, PREFIX_PGF,
+                                PREFIX_MASP, PREFIX_TMP_STORAGE};
+    const uint32_t networks[] = {HDPATH_1_DEFAULT, HDPATH_1_TESTNET};
+
+    for (const uint32_t coinType : networks) {
+        hdPath[1] = coinType;
+        const char *hrp = coinType == HDPATH_1_TESTNET ? "testtnam" : "tnam";
+
+        for (uint8_t tag = 0; tag < sizeof(prefixes); tag++) {
+            if (prefixes[tag] == 0xFF) {
+                continue;
+            }
+            AddressAlt addr = {};
+            addr.tag = 2;
+            addr.Internal.tag = tag;
+
+            uint8_t raw[ADDRESS_LEN_BYTES] = {prefixes[tag]};
+            char expected[100] = {0};
+            char address[100] = {0};
+            ASSERT_EQ(bech32EncodeFromBytes(expected, sizeof(expected), hrp, raw, sizeof(raw), 1, BECH32_ENCODING_BECH32M), zxerr_ok);
+            ASSERT_EQ(crypto_encodeAltAddress(&addr, address, sizeof(address)), parser_ok);
+            EXPECT_STREQ(address, expected) << "internal tag " << (int)tag;
+        }
+
+        // Payload addresses go through the encoder
+        const uint8_t ethAddr[ADDRESS_LEN_BYTES - 1] = {0xDE, 0xAD, 0xBE, 0xEF};
+        AddressAlt erc20 = {};
+        erc20.tag = 2;
+        erc20.Internal.tag = 8;
+        erc20.Internal.Erc20.erc20Addr.ptr = ethAddr;
+        erc20.Internal.Erc20.erc20Addr.len = sizeof(ethAddr);
+
+        uint8_t raw[ADDRESS_LEN_BYTES] = {PREFIX_ERC20};
+        memcpy(raw + 1, ethAddr, sizeof(ethAddr));
+        char expected[100] = {0};
+        char address[100] = {0};
+        ASSERT_EQ(bech32EncodeFromBytes(expected, sizeof(expected), hrp, raw, sizeof(raw), 1, BECH32_ENCODING_BECH32M), zxerr_ok);
+        ASSERT_EQ(crypto_encodeAltAddress(&erc20, address, sizeof(address)), parser_ok);
+        EXPECT_STREQ(address, expected);
+
+        AddressAlt unknown = {};
+        unknown.tag = 2;
+        unknown.Internal.tag = sizeof(prefixes);
+        EXPECT_EQ(crypto_encodeAltAddress(&unknown, address, sizeof(address)), parser_value_out_of_range);
+    }
+}
+
 TEST(LEB128, LEB128Encoding) {
         const vector<LEB128Testcase> leb128_encoding {
                 {12, {0x0C}, 1},
@@ -0,0 +1,246 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "coin.h"
+#include "parser_impl_common.h"
+#include "tx_stream.h"
+
+static std::vector<uint8_t> streamed;
+static size_t streamCapacity = SIZE_MAX;
+
+static uint32_t collect(const uint8_t *data, uint32_t dataLen) {
+    if (streamed.size() + dataLen > streamCapacity) {
+        return 0;
+    }
+    streamed.insert(streamed.end(), data, data + dataLen);
+    return dataLen;
+}
+
+static void appendU32(std::vector<uint8_t> &out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back((uint8_t)(value >> (8 * i)));
+    }
+}
+
+// discriminant, salt, commitment, optional tag
+static std::vector<uint8_t> committedSection(uint8_t discriminant, const std::vector<uint8_t> &body, bool inlineBody, const char *tag) {
+    std::vector<uint8_t> section = {discriminant};
+    for (uint8_t i = 0; i < SALT_LEN; i++) {
+        section.push_back(0xA0 + i);
+    }
+    if (inlineBody) {
+        section.push_back(1);
+        appendU32(section, (uint32_t)body.size());
+        section.insert(section.end(), body.begin(), body.end());
+    } else {
+        uint8_t bodyHash[HASH_LEN] = {0};
+        EXPECT_EQ(hash_sha256(body.data(), body.size(), bodyHash), zxerr_ok);
+        section.push_back(0);
+        section.insert(section.end(), bodyHash, bodyHash + HASH_LEN);
+    }
+    section.push_back(tag != nullptr);
+    if (tag != nullptr) {
+        appendU32(section, (uint32_t)strlen(tag));
+        section.insert(section.end(), tag, tag + strlen(tag));
+    }
+    return section;
+}
+
+static std::vector<uint8_t> pattern(size_t len, uint8_t seed) {
+    std::vector<uint8_t> out(len);
+    for (size_t i = 0; i < len; i++) {
+        out[i] = (uint8_t)(i * seed + 1);
+    }
+    return out;
+}
+
+// Header and sections are split in uneven chunks, so fields straddle chunk boundaries
+TEST(TxStream, CompactsLargeBodies) {
+    const std::vector<uint8_t> header = pattern(100, 3);
+    const std::vector<uint8_t> data = {DISCRIMINANT_DATA, 1, 2, 3, 4, 5, 6, 7, 8, 2, 0, 0, 0, 0xAB, 0xCD};
+    const std::vector<uint8_t> content = pattern(20000, 7);
+    const std::vector<uint8_t> memo = pattern(TX_STREAM_INLINE_MAX, 5);
+    const std::vector<uint8_t> code = pattern(TX_STREAM_INLINE_MAX + 1, 11);
+
+    const std::vector<std::vector<uint8_t>> sections = {
+        header,
+        data,
+        committedSection(DISCRIMINANT_EXTRA_DATA, content, true, "vp_user.wasm"),
+        committedSection(DISCRIMINANT_EXTRA_DATA, memo, true, nullptr),
+        committedSection(DISCRIMINANT_CODE, code, true, "tx_init_proposal.wasm"),
+        committedSection(DISCRIMINANT_CODE, content, false, ""),
+    };
+    std::vector<uint8_t> expected = header;
+    for (const auto &section : {data,
+                                committedSection(DISCRIMINANT_EXTRA_DATA, content, false, "vp_user.wasm"),
+                                committedSection(DISCRIMINANT_EXTRA_DATA, memo, true, nullptr),
+                                committedSection(DISCRIMINANT_CODE, code, false, "tx_init_proposal.wasm"),
+                                committedSection(DISCRIMINANT_CODE, content, false, "")}) {
+        expected.insert(expected.end(), section.begin(), section.end());
+    }
+
+    const size_t chunks[] = {1, 3, 250, 7, 4096, 2, 33};
+    for (size_t first : chunks) {
+        streamed.clear();
+        streamCapacity = SIZE_MAX;
+        tx_stream_t stream;
+        ASSERT_EQ(tx_stream_init(&stream, collect), zxerr_ok);
+
+        size_t total = 0;
+        for (size_t s = 0; s < sections.size(); s++) {
+            const std::vector<uint8_t> &section = sections[s];
+            for (size_t offset = 0, step = 0; offset < section.size(); step++) {
+                const size_t chunk = std::min(chunks[(first + step) % 7], section.size() - offset);
+                ASSERT_EQ(tx_stream_update(&stream, section.data() + offset, (uint32_t)chunk,
+                                           s > 0 && offset == 0 ? TX_STREAM_SECTION_START : 0), zxerr_ok);
+                offset += chunk;
+            }
+            total += section.size();
+        }
+        ASSERT_EQ(tx_stream_final(&stream), zxerr_ok);
+        EXPECT_EQ(stream.received, total);
+        for (uint8_t idx = 1; idx <= TX_STREAM_MAX_SECTIONS; idx++) {
+            EXPECT_EQ(tx_stream_compacted(&stream, idx), idx == 2 || idx == 4) << "section " << (int)idx;
+        }
+        EXPECT_EQ(streamed, expected) << "chunk " << first;
+    }
+}
+
+TEST(TxStream, RejectsBrokenFraming) {
+    const std::vector<uint8_t> section = committedSection(DISCRIMINANT_EXTRA_DATA, pattern(1000, 3), true, "tag");
+    tx_stream_t stream;
+
+    // Stopping in the middle of the body
+    streamed.clear();
+    streamCapacity = SIZE_MAX;
+    ASSERT_EQ(tx_stream_init(&stream, collect), zxerr_ok);
+    ASSERT_EQ(tx_stream_update(&stream, section.data(), 500, TX_STREAM_SECTION_START), zxerr_ok);
+    EXPECT_EQ(tx_stream_final(&stream), zxerr_encoding_failed);
+
+    // A new section before the previous one ended
+    EXPECT_EQ(tx_stream_update(&stream, section.data(), 1, TX_STREAM_SECTION_START), zxerr_encoding_failed);
+
+    // Bytes after the tag that do not start a section
+    ASSERT_EQ(tx_stream_init(&stream, collect), zxerr_ok);
+    ASSERT_EQ(tx_stream_update(&stream, section.data(), (uint32_t)section.size(), TX_STREAM_SECTION_START), zxerr_ok);
+    EXPECT_EQ(tx_stream_update(&stream, section.data(), 1, 0), zxerr_encoding_failed);
+
+    // Unknown commitment
+    std::vector<uint8_t> broken = section;
+    broken[1 + SALT_LEN] = 2;
+    ASSERT_EQ(tx_stream_init(&stream, collect), zxerr_ok);
+    EXPECT_EQ(tx_stream_update(&stream, broken.data(), (uint32_t)broken.size(), TX_STREAM_SECTION_START), zxerr_encoding_failed);
+
+    // Compacted output that does not fit
+    streamed.clear();
+    streamCapacity = 16;
+    ASSERT_EQ(tx_stream_init(&stream, collect), zxerr_ok);
+    EXPECT_EQ(tx_stream_update(&stream, section.data(), (uint32_t)section.size(), TX_STREAM_SECTION_START), zxerr_buffer_too_small);
+    streamCapacity = SIZE_MAX;
+
+    // Keeping a body outside of a section start
+    ASSERT_EQ(tx_stream_init(&stream, collect), zxerr_ok);
+    EXPECT_EQ(tx_stream_update(&stream, section.data(), 1, TX_STREAM_KEEP_BODY), zxerr_encoding_failed);
+}
+
+// A memo over TX_STREAM_INLINE_MAX is only shown as text when the host keeps it inline
+TEST(TxStream, KeepsMarkedMemo) {
+    const std::vector<uint8_t> header = pattern(64, 3);
+    const std::vector<uint8_t> memo(TX_STREAM_INLINE_MAX + 300, 'm');
+    const std::vector<uint8_t> section = committedSection(DISCRIMINANT_EXTRA_DATA, memo, true, nullptr);
+
+    for (const bool keep : {true, false}) {
+        streamed.clear();
+        streamCapacity = SIZE_MAX;
+        tx_stream_t stream;
+        ASSERT_EQ(tx_stream_init(&stream, collect), zxerr_ok);
+        ASSERT_EQ(tx_stream_update(&stream, header.data(), (uint32_t)header.size(), 0), zxerr_ok);
+
+        const uint8_t flags = TX_STREAM_SECTION_START | (keep ? TX_STREAM_KEEP_BODY : 0);
+        ASSERT_EQ(tx_stream_update(&stream, section.data(), 200, flags), zxerr_ok);
+        ASSERT_EQ(tx_stream_update(&stream, section.data() + 200, (uint32_t)section.size() - 200, 0), zxerr_ok);
+        ASSERT_EQ(tx_stream_final(&stream), zxerr_ok);
+
+        std::vector<uint8_t> expected = header;
+        const std::vector<uint8_t> written = committedSection(DISCRIMINANT_EXTRA_DATA, memo, keep, nullptr);
+        expected.insert(expected.end(), written.begin(), written.end());
+        EXPECT_EQ(streamed, expected) << "keep " << keep;
+        EXPECT_EQ(tx_stream_compacted(&stream, 1), !keep);
+    }
+}
+
+// Data sections are written as DATA_SECTION_COMPACTED followed by their section hash
+TEST(TxStream, CompactsLargeData) {
+    const std::vector<uint8_t> header = pattern(64, 3);
+    const std::vector<uint8_t> body = pattern(TX_STREAM_INLINE_MAX + 1000, 13);
+    std::vector<uint8_t> section = {DISCRIMINANT_DATA, 1, 2, 3, 4, 5, 6, 7, 8};
+    appendU32(section, (uint32_t)body.size());
+    section.insert(section.end(), body.begin(), body.end());
+    const std::vector<uint8_t> code = committedSection(DISCRIMINANT_CODE, pattern(100, 7), true, "tx_custom.wasm");
+
+    for (const bool keep : {true, false}) {
+        streamed.clear();
+        streamCapacity = SIZE_MAX;
+        tx_stream_t stream;
+        ASSERT_EQ(tx_stream_init(&stream, collect), zxerr_ok);
+        ASSERT_EQ(tx_stream_update(&stream, header.data(), (uint32_t)header.size(), 0), zxerr_ok);
+
+        // The length straddles two chunks
+        const uint8_t flags = TX_STREAM_SECTION_START | (keep ? TX_STREAM_KEEP_BODY : 0);
+        ASSERT_EQ(tx_stream_update(&stream, section.data(), 11, flags), zxerr_ok);
+        ASSERT_EQ(tx_stream_update(&stream, section.data() + 11, (uint32_t)section.size() - 11, 0), zxerr_ok);
+        ASSERT_EQ(tx_stream_update(&stream, code.data(), (uint32_t)code.size(), TX_STREAM_SECTION_START), zxerr_ok);
+        ASSERT_EQ(tx_stream_final(&stream), zxerr_ok);
+
+        std::vector<uint8_t> expected = header;
+        if (keep) {
+            expected.insert(expected.end(), section.begin(), section.end());
+        } else {
+            uint8_t sectionHash[HASH_LEN] = {0};
+            EXPECT_EQ(hash_sha256(section.data(), section.size(), sectionHash), zxerr_ok);
+            expected.insert(expected.end(), section.begin(), section.begin() + 1 + SALT_LEN);
+            appendU32(expected, DATA_SECTION_COMPACTED);
+            expected.insert(expected.end(), sectionHash, sectionHash + HASH_LEN);
+        }
+        expected.insert(expected.end(), code.begin(), code.end());
+        EXPECT_EQ(streamed, expected) << "keep " << keep;
+        EXPECT_EQ(tx_stream_compacted(&stream, 1), !keep);
+        EXPECT_FALSE(tx_stream_compacted(&stream, 2));
+    }
+
+    // The host cannot send the compacted form itself
+    std::vector<uint8_t> marked = {DISCRIMINANT_DATA, 1, 2, 3, 4, 5, 6, 7, 8};
+    appendU32(marked, DATA_SECTION_COMPACTED);
+    tx_stream_t stream;
+    ASSERT_EQ(tx_stream_init(&stream, collect), zxerr_ok);
+    EXPECT_EQ(tx_stream_update(&stream, marked.data(), (uint32_t)marked.size(), TX_STREAM_SECTION_START), zxerr_encoding_failed);
+}
+
+TEST(TxStream, RejectsTooManySections) {
+    const std::vector<uint8_t> section = committedSection(DISCRIMINANT_EXTRA_DATA, pattern(10, 3), true, nullptr);
+    streamed.clear();
+    streamCapacity = SIZE_MAX;
+    tx_stream_t stream;
+    ASSERT_EQ(tx_stream_init(&stream, collect), zxerr_ok);
+    for (uint8_t i = 0; i < TX_STREAM_MAX_SECTIONS; i++) {
+        ASSERT_EQ(tx_stream_update(&stream, section.data(), (uint32_t)section.size(), TX_STREAM_SECTION_START), zxerr_ok);
+    }
+    EXPECT_EQ(tx_stream_update(&stream, section.data(), (uint32_t)section.size(), TX_STREAM_SECTION_START), zxerr_encoding_failed);
+}
@@ -60,6 +60,82 @@ function hashSignatureSec(pubkeys: Buffer[], salt: Buffer, hashes: { [index: num
   return Buffer.from(hash.array());
 }
 
+// Byte length of the serialized section at offset
+function sectionLength(blob: Buffer, offset: number): number {
+  let pos = offset + 1
+  switch (blob[offset]) {
+    case 0x00: // Data
+      pos += 8
+      pos += 4 + blob.readUInt32LE(pos)
+      break
+    case 0x01: // ExtraData
+    case 0x02: // Code
+      pos += 8
+      pos += blob[pos] === 0x00 ? 1 + 32 : 1 + 4 + blob.readUInt32LE(pos + 1)
+      pos += blob[pos] === 0x00 ? 1 : 1 + 4 + blob.readUInt32LE(pos + 1)
+      break
+    case 0x03: { // Signature
+      pos += 4 + 32 * blob.readUInt32LE(pos)
+      if (blob[pos++] === 0x01) {
+        const pubkeys = blob.readUInt32LE(pos)
+        pos += 4
+        for (let i = 0; i < pubkeys; i++) {
+          pos += 1 + (blob[pos] === 0x00 ? 32 : 33)
+        }
+      } else {
+        pos += 21
+      }
+      const signatures = blob.readUInt32LE(pos)
+      pos += 4
+      for (let i = 0; i < signatures; i++) {
+        pos += 2 + (blob[pos + 1] === 0x00 ? 64 : 65)
+      }
+      break
+    }
+    default:
+      throw new Error(`Unexpected section ${blob[offset]}`)
+  }
+  return pos - offset
+}
+
+// Splits a transaction in the header, up to and including the section count, and its sections
+function splitSections(blob: Buffer, sectionsOffset: number): { header: Buffer; sections: Buffer[] } {
+  const sections = []
+  const count = blob.readUInt32LE(sectionsOffset - 4)
+  let offset = sectionsOffset
+  for (let i = 0; i < count; i++) {
+    const len = sectionLength(blob, offset)
+    sections.push(blob.subarray(offset, offset + len))
+    offset += len
+  }
+  expect(offset).toEqual(blob.length)
+  return { header: blob.subarray(0, sectionsOffset), sections }
+}
+
+function verifySignature(resp: any, rawPubkey: Buffer, sectionHashes: { [index: number]: Buffer }) {
+  expect(resp.returnCode).toEqual(0x9000)
+  expect(resp.errorMessage).toEqual('No errors')
+  expect(resp).toHaveProperty('signature')
+
+  const signature = resp.signature ?? new Signature()
+  expect(signature.rawPubkey).toEqual(rawPubkey);
+  // Verify raw signature
+  const unsignedRawSigHash = hashSignatureSec([], signature.raw_salt, sectionHashes, signature.raw_indices, null, null)
+  const rawSig = ed25519.verify(signature.raw_signature.subarray(1), unsignedRawSigHash, signature.rawPubkey.subarray(1))
+
+  // Verify wrapper signature
+  const prefix = new Uint8Array([0x03]);
+  const rawHash: Buffer = hashSignatureSec([signature.rawPubkey], signature.raw_salt, sectionHashes, signature.raw_indices, signature.raw_signature, prefix);
+  const tmpHashes = {...sectionHashes};
+
+  tmpHashes[Object.keys(tmpHashes).length - 1] = rawHash;
+
+  const unsignedWrapperSigHash = hashSignatureSec([], signature.wrapper_salt, tmpHashes, signature.wrapper_indices, null, null);
+  const wrapperSig = ed25519.verify(signature.wrapper_signature.subarray(1), unsignedWrapperSigHash, rawPubkey.subarray(1));
+
+  expect(wrapperSig && rawSig).toEqual(true)
+}
+
 const TEST_DATA = [
     {
       name: 'bond',
@@ -144,28 +220,72 @@ describe.each(models)('Transactions', function (m) {
       const resp = await respRequest
       // console.log(resp, m.name, data.name)
 
-      expect(resp.returnCode).toEqual(0x9000)
-      expect(resp.errorMessage).toEqual('No errors')
-      expect(resp).toHaveProperty('signature')
+      console.log(resp.signature)
+      verifySignature(resp, resp_addr.rawPubkey, data.sectionHashes)
+    } finally {
+      await sim.close()
+    }
+  })
+})
+
+// Streamed uploads keep the data section inline, and compact the init_proposal content. The
+// section hashes do not change, so the review and the signatures match the regular upload.
+const STREAMED_DATA = [
+  { name: 'bond', sectionsOffset: 297, keepSections: [0] },
+  { name: 'init_proposal', sectionsOffset: 305, keepSections: [1] },
+]
 
-      const signature = resp.signature ?? new Signature()
-      expect(signature.rawPubkey).toEqual(resp_addr.rawPubkey);
-      console.log(signature)
-      // Verify raw signature
-      const unsignedRawSigHash = hashSignatureSec([], signature.raw_salt, data.sectionHashes, signature.raw_indices, null, null)
-      const rawSig = ed25519.verify(signature.raw_signature.subarray(1), unsignedRawSigHash, signature.rawPubkey.subarray(1))
+describe.each(models)('Streamed transactions', function (m) {
+  test.concurrent.each(STREAMED_DATA)('Sign streamed transaction', async function (streamed) {
+    const data = TEST_DATA.find(tx => tx.name === streamed.name)!
+    const sim = new Zemu(m.path)
+    try {
+      await sim.start({ ...defaultOptions, model: m.name })
+      const app = new NamadaApp(sim.getTransport())
+
+      const resp_addr = await app.getAddressAndPubKey(hdpath)
+
+      const { header, sections } = splitSections(data.blob, streamed.sectionsOffset)
+      const respRequest = app.signStreamed(hdpath, header, sections, streamed.keepSections)
+      await sim.waitUntilScreenIsNot(sim.getMainMenuSnapshot(), 20000)
+      await sim.compareSnapshotsAndApprove('.', `${m.prefix.toLowerCase()}-sign-streamed-${data.name}`)
+
+      verifySignature(await respRequest, resp_addr.rawPubkey, data.sectionHashes)
+    } finally {
+      await sim.close()
+    }
+  })
+
+  test.concurrent('Resume streamed transaction', async function () {
+    const streamed = STREAMED_DATA[1]
+    const data = TEST_DATA.find(tx => tx.name === streamed.name)!
+    const sim = new Zemu(m.path)
+    try {
+      await sim.start({ ...defaultOptions, model: m.name })
+      const app = new NamadaApp(sim.getTransport())
 
-      // Verify wrapper signature
-      const prefix = new Uint8Array([0x03]);
-      const rawHash: Buffer = hashSignatureSec([signature.rawPubkey], signature.raw_salt, data.sectionHashes, signature.raw_indices, signature.raw_signature, prefix);
-      const tmpHashes = {...data.sectionHashes};
+      const resp_addr = await app.getAddressAndPubKey(hdpath)
 
-      tmpHashes[Object.keys(tmpHashes).length - 1] = rawHash;
+      // The first added chunk reaches the device but its answer is lost, the upload
+      // has to resume from the offset the device reports
+      const sendChunkApdu = app.sendChunkApdu.bind(app)
+      let dropped = false
+      app.sendChunkApdu = async (ins: number, p1: number, p2: number, chunk: Buffer, statusList: number[]) => {
+        const response = await sendChunkApdu(ins, p1, p2, chunk, statusList)
+        if (!dropped && p1 === 0x01) {
+          dropped = true
+          throw new Error('Transport error')
+        }
+        return response
+      }
 
-      const unsignedWrapperSigHash = hashSignatureSec([], signature.wrapper_salt, tmpHashes, signature.wrapper_indices, null, null);
-      const wrapperSig = ed25519.verify(signature.wrapper_signature.subarray(1), unsignedWrapperSigHash, resp_addr.rawPubkey.subarray(1));
+      const { header, sections } = splitSections(data.blob, streamed.sectionsOffset)
+      const respRequest = app.signStreamed(hdpath, header, sections, streamed.keepSections)
+      await sim.waitUntilScreenIsNot(sim.getMainMenuSnapshot(), 20000)
+      await sim.compareSnapshotsAndApprove('.', `${m.prefix.toLowerCase()}-sign-resume-${data.name}`)
 
-      expect(wrapperSig && rawSig).toEqual(true)
+      expect(dropped).toEqual(true)
+      verifySignature(await respRequest, resp_addr.rawPubkey, data.sectionHashes)
     } finally {
       await sim.close()
     }
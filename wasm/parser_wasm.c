@@ -0,0 +1,81 @@
+/*******************************************************************************
+*   (c) 2018 - 2024 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <emscripten/emscripten.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_mode.h"
+#include "coin.h"
+#include "crypto_helper.h"
+#include "zxmacros.h"
+#include "parser.h"
+
+extern uint32_t hdPath[HDPATH_LEN_DEFAULT];
+
+// The parsed transaction keeps pointers into the input, so the blob is owned here
+static uint8_t *tx_buffer = NULL;
+static parser_tx_t tx_obj;
+static parser_context_t ctx_parsed_tx;
+
+// coinType is the unhardened second path element, it selects the HRPs as the device does for hdPath[1]
+EMSCRIPTEN_KEEPALIVE
+uint8_t wasm_parser_parse(const uint8_t *data, uint32_t dataLen, uint8_t expertMode, uint32_t coinType) {
+    free(tx_buffer);
+    tx_buffer = NULL;
+    MEMZERO(&tx_obj, sizeof(tx_obj));
+    MEMZERO(&ctx_parsed_tx, sizeof(ctx_parsed_tx));
+
+    if (data == NULL || dataLen == 0 || dataLen > UINT16_MAX) {
+        return parser_init_context_empty;
+    }
+
+    tx_buffer = malloc(dataLen);
+    if (tx_buffer == NULL) {
+        return parser_unexpected_error;
+    }
+    memcpy(tx_buffer, data, dataLen);
+
+    hdPath[1] = 0x80000000u | coinType;
+    if (hdPath[1] != HDPATH_1_DEFAULT && hdPath[1] != HDPATH_1_TESTNET) {
+        return parser_unexpected_value;
+    }
+    if (crypto_setNetwork(hdPath[1]) != zxerr_ok) {
+        return parser_unexpected_error;
+    }
+
+    app_mode_set_expert(expertMode);
+
+    CHECK_ERROR(parser_parse(&ctx_parsed_tx, tx_buffer, dataLen, &tx_obj))
+    return parser_validate(&ctx_parsed_tx);
+}
+
+EMSCRIPTEN_KEEPALIVE
+uint8_t wasm_parser_getNumItems(uint8_t *numItems) {
+    return parser_getNumItems(&ctx_parsed_tx, numItems);
+}
+
+EMSCRIPTEN_KEEPALIVE
+uint8_t wasm_parser_getItem(uint8_t displayIdx,
+                            char *outKey, uint16_t outKeyLen,
+                            char *outVal, uint16_t outValLen,
+                            uint8_t pageIdx, uint8_t *pageCount) {
+    return parser_getItem(&ctx_parsed_tx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
+}
+
+EMSCRIPTEN_KEEPALIVE
+const char *wasm_parser_getErrorDescription(uint8_t err) {
+    return parser_getErrorDescription(err);
+}